@@ -0,0 +1,73 @@
+// one instance of libansnd with its voices, built as its own shared library
+// the library keeps all state in statics and tops out at ANSND_MAX_VOICES, so larger voice counts load several banks
+
+#include "../../src/ansndlib.c"
+
+#define BANK_EXPORT __attribute__((visibility("default")))
+
+// the DSP never reads the samples here, only the addresses matter
+#define BANK_SAMPLE_COUNT 4096
+
+static u32 bank_voice_ids[ANSND_MAX_VOICES];
+static u32 bank_voice_count = 0;
+static u32 bank_next_change = 0;
+
+// a spread of what a game keeps running, pitched, looped, filtered and modulated voices
+BANK_EXPORT s32 bank_setup(u32 voice_count) {
+	ansnd_initialize();
+
+	for (u32 i = 0; i < voice_count; ++i) {
+		s32 voice_id = ansnd_allocate_voice();
+		if (voice_id < 0) {
+			return voice_id;
+		}
+
+		ansnd_pcm_voice_config_t config;
+		memset(&config, 0, sizeof(ansnd_pcm_voice_config_t));
+		config.samplerate     = 32000;
+		config.format         = ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM;
+		config.channels       = (i % 4 == 0) ? 2 : 1;
+		config.pitch          = 0.5f + (i % 7) * 0.25f;
+		config.left_volume    = 0.5f;
+		config.right_volume   = 0.5f;
+		config.frame_data_ptr = 0x00100000;
+		config.frame_count    = BANK_SAMPLE_COUNT / config.channels;
+		config.loop_end_offset = config.frame_count;
+
+		s32 error = ansnd_configure_pcm_voice(voice_id, &config);
+		if (error == ANSND_ERROR_OK && (i % 3 == 0)) {
+			error = ansnd_set_voice_lfo(voice_id, ANSND_LFO_SHAPE_SINE, 5.f, 0.5f, 0.f);
+		}
+		if (error == ANSND_ERROR_OK && (i % 5 == 0)) {
+			error = ansnd_set_voice_biquad(voice_id, ANSND_BIQUAD_TYPE_LOW_PASS, 2000.f, 0.7071f);
+		}
+		if (error == ANSND_ERROR_OK) {
+			error = ansnd_start_voice(voice_id);
+		}
+		if (error != ANSND_ERROR_OK) {
+			return error;
+		}
+
+		bank_voice_ids[i] = voice_id;
+	}
+	bank_voice_count = voice_count;
+
+	// the first pass initializes every voice, which is not what a running game pays for
+	ansnd_dsp_request_callback(&ansnd_dsp_task);
+
+	return ANSND_ERROR_OK;
+}
+
+// what the game changes between two cycles
+BANK_EXPORT void bank_change(u32 changes) {
+	for (u32 i = 0; (i < changes) && (bank_voice_count > 0); ++i) {
+		f32 volume = 0.25f + (bank_next_change % 3) * 0.25f;
+		ansnd_set_voice_volume(bank_voice_ids[bank_next_change % bank_voice_count], volume, volume);
+		bank_next_change++;
+	}
+}
+
+// the CPU side of one DSP cycle, as run from the DSP interrupt
+BANK_EXPORT void bank_sync() {
+	ansnd_dsp_request_callback(&ansnd_dsp_task);
+}
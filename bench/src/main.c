@@ -0,0 +1,128 @@
+// times the request callback sync pass on the host, with warm and cold caches
+// usage: sync_bench <bank library> [passes]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+
+#define VOICES_PER_BANK 48
+#define MAX_BANKS       3
+#define EVICT_SIZE      (16 * 1024 * 1024)
+
+typedef int  (*bank_setup_t)(unsigned int voice_count);
+typedef void (*bank_change_t)(unsigned int changes);
+typedef void (*bank_sync_t)(void);
+
+typedef struct bank_t {
+	bank_setup_t  setup;
+	bank_change_t change;
+	bank_sync_t   sync;
+} bank_t;
+
+static const unsigned int voice_counts[] = { 48, 96, 128 };
+
+static unsigned char* evict_buffer;
+
+static double now_ns() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// stands in for the game running between two DSP interrupts
+static void evict_caches() {
+	for (size_t i = 0; i < EVICT_SIZE; i += 64) {
+		evict_buffer[i]++;
+	}
+}
+
+// every bank needs its own copy of the library, dlopen hands back the same one for the same file
+static int load_bank(const char* path, unsigned int index, bank_t* bank) {
+	char copy_path[4096];
+	snprintf(copy_path, sizeof(copy_path), "%s.bank%u", path, index);
+
+	FILE* in  = fopen(path, "rb");
+	FILE* out = fopen(copy_path, "wb");
+	if (!in || !out) {
+		return -1;
+	}
+	char buffer[65536];
+	size_t size;
+	while ((size = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+		fwrite(buffer, 1, size, out);
+	}
+	fclose(in);
+	fclose(out);
+
+	void* library = dlopen(copy_path, RTLD_NOW | RTLD_LOCAL);
+	remove(copy_path);
+	if (!library) {
+		fprintf(stderr, "%s\n", dlerror());
+		return -1;
+	}
+
+	bank->setup  = (bank_setup_t)dlsym(library, "bank_setup");
+	bank->change = (bank_change_t)dlsym(library, "bank_change");
+	bank->sync   = (bank_sync_t)dlsym(library, "bank_sync");
+	return (bank->setup && bank->change && bank->sync) ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <bank library> [passes]\n", argv[0]);
+		return 1;
+	}
+	unsigned int passes = (argc > 2) ? atoi(argv[2]) : 2000;
+
+	evict_buffer = calloc(EVICT_SIZE, 1);
+
+	printf("%8s %14s %14s %14s\n", "voices", "warm ns/pass", "cold ns/pass", "cold ns/voice");
+
+	for (unsigned int c = 0; c < sizeof(voice_counts) / sizeof(voice_counts[0]); ++c) {
+		unsigned int voices = voice_counts[c];
+		unsigned int bank_count = (voices + VOICES_PER_BANK - 1) / VOICES_PER_BANK;
+
+		bank_t banks[MAX_BANKS];
+		for (unsigned int b = 0; b < bank_count; ++b) {
+			unsigned int bank_voices = voices - b * VOICES_PER_BANK;
+			if (bank_voices > VOICES_PER_BANK) {
+				bank_voices = VOICES_PER_BANK;
+			}
+			if (load_bank(argv[1], c * MAX_BANKS + b, &banks[b]) ||
+				banks[b].setup(bank_voices)) {
+				fprintf(stderr, "could not set up %u voices\n", voices);
+				return 1;
+			}
+		}
+
+		double warm = 0.0;
+		double cold = 0.0;
+		for (unsigned int p = 0; p < passes; ++p) {
+			for (unsigned int b = 0; b < bank_count; ++b) {
+				banks[b].change(4);
+			}
+			double start = now_ns();
+			for (unsigned int b = 0; b < bank_count; ++b) {
+				banks[b].sync();
+			}
+			warm += now_ns() - start;
+
+			for (unsigned int b = 0; b < bank_count; ++b) {
+				banks[b].change(4);
+			}
+			evict_caches();
+			start = now_ns();
+			for (unsigned int b = 0; b < bank_count; ++b) {
+				banks[b].sync();
+			}
+			cold += now_ns() - start;
+		}
+
+		printf("%8u %14.0f %14.0f %14.1f\n", voices, warm / passes, cold / passes, cold / passes / voices);
+	}
+
+	free(evict_buffer);
+	return 0;
+}
@@ -0,0 +1,74 @@
+// host stand-in for the libogc header, only what libansnd uses
+// the DSP, audio and thread calls do nothing, see ogc_stubs.c
+#ifndef GCCORE_H
+#define GCCORE_H
+
+#include <gctypes.h>
+
+#define DSPTASK_RUN  1
+#define DSPTASK_DONE 2
+
+typedef struct _dsp_task dsptask_t;
+typedef void (*DSPTaskCallback)(dsptask_t* task);
+
+struct _dsp_task {
+	u32 state;
+	u32 prio;
+	void* iram_maddr;
+	u32 iram_len;
+	u32 iram_addr;
+	void* dram_maddr;
+	u32 dram_len;
+	u32 dram_addr;
+	u16 init_vec;
+	u16 resume_vec;
+	DSPTaskCallback init_cb;
+	DSPTaskCallback res_cb;
+	DSPTaskCallback req_cb;
+	DSPTaskCallback done_cb;
+};
+
+#define SYS_BASE_CACHED            0x80000000
+#define MEM_VIRTUAL_TO_PHYSICAL(x) ((u32)(uintptr_t)(x) & ~0xC0000000)
+
+void       DSP_Init(void);
+dsptask_t* DSP_AddTask(dsptask_t* task);
+void       DSP_AssertTask(dsptask_t* task);
+void       DSP_CancelTask(dsptask_t* task);
+void       DSP_SendMailTo(u32 mail);
+u32        DSP_CheckMailTo(void);
+
+#define AI_SAMPLERATE_48KHZ 0
+#define AI_SAMPLERATE_32KHZ 1
+#define AI_SAMPLERATE_96KHZ 2
+
+typedef void (*AIDCallback)(void);
+
+void        AUDIO_Init(u8* stack);
+void        AUDIO_StopDMA(void);
+void        AUDIO_StartDMA(void);
+void        AUDIO_SetDSPSampleRate(u8 rate);
+void        AUDIO_InitDMA(u32 buffer, u32 length);
+AIDCallback AUDIO_RegisterDMACallback(AIDCallback callback);
+
+u32 AR_GetBaseAddress(void);
+u32 AR_GetSize(void);
+
+void DCInvalidateRange(void* start, u32 length);
+void DCFlushRange(void* start, u32 length);
+
+typedef u32 lwp_t;
+typedef u32 lwpq_t;
+
+#define LWP_THREAD_NULL  0xFFFFFFFF
+#define LWP_TQUEUE_NULL  0xFFFFFFFF
+#define LWP_PRIO_HIGHEST 127
+
+s32  LWP_CreateThread(lwp_t* thread, void* (*entry)(void*), void* arguments, void* stack_base, u32 stack_size, u8 priority);
+s32  LWP_JoinThread(lwp_t thread, void** value);
+s32  LWP_InitQueue(lwpq_t* queue);
+void LWP_CloseQueue(lwpq_t queue);
+s32  LWP_ThreadSleep(lwpq_t queue);
+void LWP_ThreadSignal(lwpq_t queue);
+
+#endif
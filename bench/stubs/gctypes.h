@@ -0,0 +1,21 @@
+// host stand-in for the libogc header, only what libansnd uses
+#ifndef GCTYPES_H
+#define GCTYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t   s8;
+typedef int16_t  s16;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef float    f32;
+typedef double   f64;
+
+#define ATTRIBUTE_ALIGN(v) __attribute__((aligned(v)))
+
+#endif
@@ -0,0 +1,9 @@
+// host stand-in for the libogc header, there are no interrupts to disable
+#ifndef PROCESSOR_H
+#define PROCESSOR_H
+
+#define _CPU_ISR_Disable(level) ((level) = 0)
+#define _CPU_ISR_Restore(level) ((void)(level))
+#define _CPU_ISR_Flash(level)   ((void)(level))
+
+#endif
@@ -0,0 +1,10 @@
+// host stand-in for the libogc header, ticks are nanoseconds
+#ifndef TIMESUPP_H
+#define TIMESUPP_H
+
+#include <gctypes.h>
+
+u64 gettime(void);
+u32 ticks_to_microsecs(u64 ticks);
+
+#endif
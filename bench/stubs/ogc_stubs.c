@@ -0,0 +1,76 @@
+// host stand-ins for the libogc calls libansnd makes
+// tasks start as soon as they are added, and the DSP never mails back on its own
+
+#include <time.h>
+#include <gccore.h>
+#include <ogc/timesupp.h>
+
+void DSP_Init(void) {}
+
+dsptask_t* DSP_AddTask(dsptask_t* task) {
+	task->state = DSPTASK_RUN;
+	return task;
+}
+
+void DSP_AssertTask(dsptask_t* task) {}
+
+void DSP_CancelTask(dsptask_t* task) {
+	task->state = DSPTASK_DONE;
+}
+
+void DSP_SendMailTo(u32 mail) {}
+
+u32 DSP_CheckMailTo(void) {
+	return 0;
+}
+
+void AUDIO_Init(u8* stack) {}
+void AUDIO_StopDMA(void) {}
+void AUDIO_StartDMA(void) {}
+void AUDIO_SetDSPSampleRate(u8 rate) {}
+void AUDIO_InitDMA(u32 buffer, u32 length) {}
+
+AIDCallback AUDIO_RegisterDMACallback(AIDCallback callback) {
+	return NULL;
+}
+
+u32 AR_GetBaseAddress(void) {
+	return 0x4000;
+}
+
+u32 AR_GetSize(void) {
+	return 0x1000000;
+}
+
+void DCInvalidateRange(void* start, u32 length) {}
+void DCFlushRange(void* start, u32 length) {}
+
+s32 LWP_CreateThread(lwp_t* thread, void* (*entry)(void*), void* arguments, void* stack_base, u32 stack_size, u8 priority) {
+	return -1;
+}
+
+s32 LWP_JoinThread(lwp_t thread, void** value) {
+	return 0;
+}
+
+s32 LWP_InitQueue(lwpq_t* queue) {
+	return -1;
+}
+
+void LWP_CloseQueue(lwpq_t queue) {}
+
+s32 LWP_ThreadSleep(lwpq_t queue) {
+	return 0;
+}
+
+void LWP_ThreadSignal(lwpq_t queue) {}
+
+u64 gettime(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+u32 ticks_to_microsecs(u64 ticks) {
+	return ticks / 1000;
+}
@@ -0,0 +1,7 @@
+// host stand-in for the libogc header, only what libansnd uses
+#ifndef OGCSYS_H
+#define OGCSYS_H
+
+#include <gctypes.h>
+
+#endif
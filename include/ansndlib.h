@@ -48,6 +48,11 @@
  * @brief Functions and types not directly related to voices.
  */
 
+/**
+ * @defgroup groups Mix Groups
+ * @brief Functions for controlling many voices at once through the mix group they are assigned to.
+ */
+
 #include <gctypes.h>
 
 /**
@@ -56,6 +61,48 @@
  */
 #define ANSND_MAX_VOICES              48
 
+/**
+ * @brief The number of aux buses voices can send to
+ * @ingroup non-voices
+ */
+#define ANSND_MAX_AUX_BUSES           2
+
+/**
+ * @brief The number of mix groups voices can be assigned to
+ * @ingroup groups
+ */
+#define ANSND_MAX_GROUPS              8
+
+/**
+ * @brief The root mix group, every voice starts in it and every other group is nested under it
+ * @ingroup groups
+ */
+#define ANSND_GROUP_MASTER            0
+
+/**
+ * @brief The number of voice classes that can be given their own polyphony limit
+ * @ingroup voices
+ */
+#define ANSND_MAX_VOICE_CLASSES       16
+
+/**
+ * @brief The number of voice templates that can exist at once
+ * @ingroup voices
+ */
+#define ANSND_MAX_VOICE_TEMPLATES     32
+
+/**
+ * @brief The voice class of voices allocated with @ref ansnd_allocate_voice
+ * @ingroup voices
+ */
+#define ANSND_VOICE_CLASS_DEFAULT     0
+
+/**
+ * @brief The highest voice priority, given to voices allocated with @ref ansnd_allocate_voice
+ * @ingroup voices
+ */
+#define ANSND_VOICE_PRIORITY_MAX      255
+
 #if defined(HW_DOL)
 	#define ANSND_DSP_FREQ_32KHZ      (54000000.0f/1686.0f) // ~32028
 	#define ANSND_DSP_FREQ_48KHZ      (54000000.0f/1124.0f) // ~48043
@@ -104,6 +151,7 @@
 #define ANSND_VOICE_STATE_PAUSED               2 ///< The voice has been paused by the user
 #define ANSND_VOICE_STATE_RUNNING              3 ///< The voice has been started by the user
 #define ANSND_VOICE_STATE_ERASED               4 ///< The voice has been deallocated by the user
+#define ANSND_VOICE_STATE_STOLEN               5 ///< The voice has been taken over by a voice of higher priority
 /** @} */
 
 /**
@@ -118,6 +166,68 @@
 #define ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM   2 //< Big-Endian Signed 16-bit PCM format, can be LR interleaved
 /** @} */
 
+/**
+ * @defgroup lfo_shapes LFO Shapes
+ * @brief LFO Shapes
+ * @ingroup voices
+ * @addtogroup lfo_shapes
+ * @{
+ */
+#define ANSND_LFO_SHAPE_OFF                    0 ///< No LFO
+#define ANSND_LFO_SHAPE_SINE                   1 ///< Sine wave LFO
+#define ANSND_LFO_SHAPE_TRIANGLE               2 ///< Triangle wave LFO
+#define ANSND_LFO_SHAPE_SQUARE                 3 ///< Square wave LFO
+/** @} */
+
+/**
+ * @defgroup glide_modes Glide Modes
+ * @brief Glide Modes
+ * @ingroup voices
+ * @addtogroup glide_modes
+ * @{
+ */
+#define ANSND_GLIDE_MODE_LINEAR                0 ///< Glide with a constant change in frequency
+#define ANSND_GLIDE_MODE_EXPONENTIAL           1 ///< Glide with a constant change in semitones
+/** @} */
+
+/**
+ * @defgroup biquad_types Biquad Filter Types
+ * @brief Biquad Filter Types
+ * @ingroup voices
+ * @addtogroup biquad_types
+ * @{
+ */
+#define ANSND_BIQUAD_TYPE_OFF                  0 ///< No filter
+#define ANSND_BIQUAD_TYPE_LOW_PASS             1 ///< 12 dB/octave low-pass filter
+#define ANSND_BIQUAD_TYPE_HIGH_PASS            2 ///< 12 dB/octave high-pass filter
+#define ANSND_BIQUAD_TYPE_BAND_PASS            3 ///< Band-pass filter with 0 dB peak gain
+/** @} */
+
+/**
+ * @defgroup resample_qualities Resample Qualities
+ * @brief Resample Qualities
+ * @ingroup voices
+ * @addtogroup resample_qualities
+ * @{
+ */
+#define ANSND_RESAMPLE_QUALITY_SINC            0 ///< Windowed sinc interpolation with a lowered cutoff when pitching down, the default
+#define ANSND_RESAMPLE_QUALITY_NEAREST         1 ///< Holds the newest sample, no interpolation
+#define ANSND_RESAMPLE_QUALITY_LINEAR          2 ///< Linear interpolation between two samples
+#define ANSND_RESAMPLE_QUALITY_CUBIC           3 ///< 4-point cubic interpolation
+/** @} */
+
+/**
+ * @defgroup callback_modes Callback Modes
+ * @brief Callback Modes
+ * @ingroup non-voices
+ * @addtogroup callback_modes
+ * @{
+ */
+#define ANSND_CALLBACK_MODE_IMMEDIATE          0 ///< Voice and stream callbacks are called from the DSP interrupt
+#define ANSND_CALLBACK_MODE_POLLED             1 ///< Voice and stream callbacks are queued until @ref ansnd_dispatch_callbacks is called
+#define ANSND_CALLBACK_MODE_THREAD             2 ///< Voice and stream callbacks are queued and called from a library thread
+/** @} */
+
 /**
  * @defgroup errors Errors
  * @brief Errors
@@ -135,13 +245,17 @@
 #define ANSND_ERROR_INVALID_SAMPLERATE        -4 ///< Invalid samplerate used for voice initialization or resulting from pitch
 #define ANSND_ERROR_INVALID_MEMORY            -5 ///< Invalid memory location given
 #define ANSND_ERROR_ALL_VOICES_USED           -6 ///< No available voices to allocate
-#define ANSND_ERROR_VOICE_ID_NOT_ALLOCATED    -7 ///< This voice id has not yet been allocated
+#define ANSND_ERROR_VOICE_ID_NOT_ALLOCATED    -7 ///< This voice id has not been allocated, or is stale
 #define ANSND_ERROR_VOICE_NOT_CONFIGURED      -8 ///< This voice has not been setup yet
 #define ANSND_ERROR_VOICE_NOT_INITIALIZED     -9 ///< This voice has not been initialized yet
 #define ANSND_ERROR_VOICE_RUNNING            -10 ///< This function cannot be called while the voice is running
 #define ANSND_ERROR_VOICE_ALREADY_LINKED     -11 ///< This voice is already linked to another and cannot be linked to a third
 #define ANSND_ERROR_VOICE_NOT_LINKED         -12 ///< This voice is not linked to another and cannot be unlinked
 #define ANSND_ERROR_DSP_STALLED              -13 ///< The DSP has stalled, likely due to playing too many resampled voices at once
+#define ANSND_ERROR_VOICE_CLASS_FULL         -14 ///< The voice class has reached its polyphony limit
+#define ANSND_ERROR_ALL_TEMPLATES_USED       -15 ///< No available voice templates to create
+#define ANSND_ERROR_THREAD_FAILED            -16 ///< The callback thread could not be created
+#define ANSND_ERROR_OUT_OF_MEMORY            -17 ///< The library could not allocate the memory it needs
 /** @} */
 
 #ifdef __cplusplus
@@ -164,6 +278,29 @@ extern "C" {
  */
 typedef void (*ansnd_voice_callback_t) (void* user_pointer, s32 voice_state);
 
+/**
+ * @brief Volume envelope type.
+ * 
+ * This is the type that is used to describe an attack/decay/sustain/release volume envelope for a voice. 
+ * The envelope is evaluated by the DSP and applied on top of the voice volume.  
+ * 
+ * A zeroed envelope is disabled.  
+ * When enabled, the release runs on the DSP after @ref ansnd_stop_voice and the voice 
+ * signals @ref ANSND_VOICE_STATE_FINISHED once it reaches silence.
+ * 
+ * @note
+ * Times are rounded up to whole processing cycles of 5 milliseconds at 48 kHz output or 
+ * 7.5 milliseconds at 32 kHz output.
+ * 
+ * @ingroup voices
+ */
+typedef struct ansnd_envelope_t {
+	u32 attack_time;   ///< The time in microseconds to rise from silence to full volume.
+	u32 decay_time;    ///< The time in microseconds to fall from full volume to the sustain level.
+	f32 sustain_level; ///< The level held until the voice is stopped, valid between 0.0 and 1.0.
+	u32 release_time;  ///< The time in microseconds to fall from the sustain level to silence.
+} ansnd_envelope_t;
+
 /**
  * @brief PCM data buffer type.
  * 
@@ -239,6 +376,8 @@ typedef struct ansnd_pcm_voice_config_t {
 	f32 left_volume;       ///< Left volume, valid between -1.0 and 1.0.
 	f32 right_volume;      ///< Right volume, valid between -1.0 and 1.0.
 	
+	ansnd_envelope_t envelope; ///< The [volume envelope](@ref ansnd_envelope_t), leave zeroed to disable.
+	
 	u32 frame_data_ptr;    ///< The pointer to the start of the data.
 	u32 frame_count;       ///< The number of frames in the buffer.
 	u32 start_offset;      ///< The offset from the start of frame_data_ptr in frames to the first frame.
@@ -336,6 +475,8 @@ typedef struct ansnd_adpcm_voice_config_t {
 	f32 left_volume;              ///< Left volume, valid between -1.0 and 1.0.
 	f32 right_volume;             ///< Right volume, valid between -1.0 and 1.0.
 	
+	ansnd_envelope_t envelope;    ///< The [volume envelope](@ref ansnd_envelope_t), leave zeroed to disable.
+	
 	u32 data_ptr;                 ///< The pointer to the start of the data.
 	u32 sample_count;             ///< The number of samples in the buffer.
 	u32 start_offset;             ///< The [offset](@ref nibble_offsets_flag) from the start of data_ptr to the first sample.
@@ -392,17 +533,64 @@ void ansnd_uninitialize();
 /**
  * @brief Allocates a new voice.
  * 
- * This allocates a voice for use.
+ * This allocates a voice for use.  
+ * The voice gets the highest priority in the default voice class, and no voice is stolen to make room for it.
+ * 
+ * The ID is a handle that is only valid until the voice is deallocated or stolen, 
+ * later calls with it return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED even once the voice is reused.
  * 
  * @return The ID of the voice on successful allocation.
  * 
  * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
  * @return May return @ref ANSND_ERROR_ALL_VOICES_USED.
+ * @return May return @ref ANSND_ERROR_VOICE_CLASS_FULL.
  * 
  * @ingroup voices
  */
 s32 ansnd_allocate_voice();
 
+/**
+ * @brief Allocates a new voice with a priority, stealing another voice if needed.
+ * 
+ * When every voice is used, or @p voice_class has reached its limit, a voice of the same or a lower priority is stolen, 
+ * from the same class if the class is full.  
+ * The lowest priority is stolen first, then the quietest, then the oldest. Linked voices are never stolen.  
+ * The stolen voice signals @ref ANSND_VOICE_STATE_STOLEN to its callback from within this function, 
+ * and the new voice gets a new ID, so the ID of the stolen voice becomes invalid.
+ * 
+ * The DSP keeps playing the stolen sound until the next cycle, 
+ * or the one after that when @p fade is set, to ramp it out instead of cutting it.
+ * 
+ * @param[in] priority    The priority of the voice, higher is more important.
+ * @param[in] voice_class The voice class counted against its polyphony limit, valid between 0 and @ref ANSND_MAX_VOICE_CLASSES - 1.
+ * @param[in] fade        Whether a stolen voice is faded out over one cycle.
+ * 
+ * @return The ID of the voice on successful allocation.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_ALL_VOICES_USED.
+ * @return May return @ref ANSND_ERROR_VOICE_CLASS_FULL.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_allocate_voice_with_priority(u8 priority, u8 voice_class, bool fade);
+
+/**
+ * @brief Sets the polyphony limit of a voice class.
+ * 
+ * Lowering the limit does not stop voices, it only applies to later allocations.
+ * 
+ * @param[in] voice_class The voice class, valid between 0 and @ref ANSND_MAX_VOICE_CLASSES - 1.
+ * @param[in] max_voices  The most voices of the class allocated at once, valid up to @ref ANSND_MAX_VOICES, default is @ref ANSND_MAX_VOICES.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_class_limit(u8 voice_class, u32 max_voices);
+
 /**
  * @brief Deallocates a voice.
  * 
@@ -452,6 +640,157 @@ s32 ansnd_configure_pcm_voice(u32 voice_id, const ansnd_pcm_voice_config_t* voic
  */
 s32 ansnd_configure_adpcm_voice(u32 voice_id, const ansnd_adpcm_voice_config_t* voice_config);
 
+/**
+ * @brief Plays a PCM one-shot.
+ * 
+ * This allocates a voice the same way as @ref ansnd_allocate_voice_with_priority, configures it, and starts it, all at once.  
+ * The voice is deallocated by the library once it finishes or is stopped, 
+ * after its callback has seen the final state, and its ID becomes invalid at that point.
+ * 
+ * @param[in] voice_config The [PCM voice config](@ref ansnd_pcm_voice_config_t) parameters.
+ * @param[in] priority     The priority of the voice, higher is more important.
+ * @param[in] voice_class  The voice class counted against its polyphony limit, valid between 0 and @ref ANSND_MAX_VOICE_CLASSES - 1.
+ * @param[in] fade         Whether a stolen voice is faded out over one cycle.
+ * 
+ * @return The ID of the voice on success, usable to stop or adjust the voice while it plays.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_DSP_STALLED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * @return May return @ref ANSND_ERROR_INVALID_MEMORY.
+ * @return May return @ref ANSND_ERROR_INVALID_CONFIGURATION.
+ * @return May return @ref ANSND_ERROR_ALL_VOICES_USED.
+ * @return May return @ref ANSND_ERROR_VOICE_CLASS_FULL.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_play_pcm_one_shot(const ansnd_pcm_voice_config_t* voice_config, u8 priority, u8 voice_class, bool fade);
+
+/**
+ * @brief Plays a ADPCM one-shot.
+ * 
+ * This allocates a voice the same way as @ref ansnd_allocate_voice_with_priority, configures it, and starts it, all at once.  
+ * The voice is deallocated by the library once it finishes or is stopped, 
+ * after its callback has seen the final state, and its ID becomes invalid at that point.
+ * 
+ * @param[in] voice_config The [ADPCM voice config](@ref ansnd_adpcm_voice_config_t) parameters.
+ * @param[in] priority     The priority of the voice, higher is more important.
+ * @param[in] voice_class  The voice class counted against its polyphony limit, valid between 0 and @ref ANSND_MAX_VOICE_CLASSES - 1.
+ * @param[in] fade         Whether a stolen voice is faded out over one cycle.
+ * 
+ * @return The ID of the voice on success, usable to stop or adjust the voice while it plays.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_DSP_STALLED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * @return May return @ref ANSND_ERROR_INVALID_MEMORY.
+ * @return May return @ref ANSND_ERROR_INVALID_CONFIGURATION.
+ * @return May return @ref ANSND_ERROR_ALL_VOICES_USED.
+ * @return May return @ref ANSND_ERROR_VOICE_CLASS_FULL.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_play_adpcm_one_shot(const ansnd_adpcm_voice_config_t* voice_config, u8 priority, u8 voice_class, bool fade);
+
+/**
+ * @brief Creates a voice template from a PCM voice config.
+ * 
+ * The config is validated and converted once, along with the initial state the DSP gets for it, 
+ * so configuring voices from the template only copies that state.  
+ * Templates are cleared when the library is initialized again.
+ * 
+ * @param[in] voice_config The [PCM voice config](@ref ansnd_pcm_voice_config_t) parameters.
+ * 
+ * @return The ID of the template on success.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * @return May return @ref ANSND_ERROR_INVALID_MEMORY.
+ * @return May return @ref ANSND_ERROR_INVALID_CONFIGURATION.
+ * @return May return @ref ANSND_ERROR_ALL_TEMPLATES_USED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_create_pcm_voice_template(const ansnd_pcm_voice_config_t* voice_config);
+
+/**
+ * @brief Creates a voice template from a ADPCM voice config.
+ * 
+ * The config is validated and converted once, along with the initial state the DSP gets for it, 
+ * so configuring voices from the template only copies that state.  
+ * Templates are cleared when the library is initialized again.
+ * 
+ * @param[in] voice_config The [ADPCM voice config](@ref ansnd_adpcm_voice_config_t) parameters.
+ * 
+ * @return The ID of the template on success.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * @return May return @ref ANSND_ERROR_INVALID_MEMORY.
+ * @return May return @ref ANSND_ERROR_INVALID_CONFIGURATION.
+ * @return May return @ref ANSND_ERROR_ALL_TEMPLATES_USED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_create_adpcm_voice_template(const ansnd_adpcm_voice_config_t* voice_config);
+
+/**
+ * @brief Destroys a voice template.
+ * 
+ * Voices already configured from the template keep their configuration.
+ * 
+ * @param[in] template_id The ID of the template.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_destroy_voice_template(u32 template_id);
+
+/**
+ * @brief Configures a voice from a voice template.
+ * 
+ * This is the same as configuring the voice with the config the template was created from.
+ * 
+ * @param[in] voice_id    The ID of the voice.
+ * @param[in] template_id The ID of the template.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_configure_voice_from_template(u32 voice_id, u32 template_id);
+
+/**
+ * @brief Plays a one-shot from a voice template.
+ * 
+ * This is the same as @ref ansnd_play_pcm_one_shot or @ref ansnd_play_adpcm_one_shot 
+ * with the config the template was created from.
+ * 
+ * @param[in] template_id The ID of the template.
+ * @param[in] priority    The priority of the voice, higher is more important.
+ * @param[in] voice_class The voice class counted against its polyphony limit, valid between 0 and @ref ANSND_MAX_VOICE_CLASSES - 1.
+ * @param[in] fade        Whether a stolen voice is faded out over one cycle.
+ * 
+ * @return The ID of the voice on success, usable to stop or adjust the voice while it plays.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_DSP_STALLED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_ALL_VOICES_USED.
+ * @return May return @ref ANSND_ERROR_VOICE_CLASS_FULL.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_play_template_one_shot(u32 template_id, u8 priority, u8 voice_class, bool fade);
+
 /**
  * @brief Links two voices.
  * 
@@ -518,6 +857,10 @@ s32 ansnd_start_voice(u32 voice_id);
 /**
  * @brief Stops the voice.
  * 
+ * If the voice has an [envelope](@ref ansnd_envelope_t), this starts its release instead 
+ * and the voice finishes once the release reaches silence. 
+ * Calling this again during the release stops the voice immediately.
+ * 
  * @param[in] voice_id The ID of the voice.
  * 
  * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
@@ -586,6 +929,8 @@ s32 ansnd_stop_looping(u32 voice_id);
 /**
  * @brief Sets the volume of a voice.
  * 
+ * The change is ramped per sample over a single processing cycle to avoid zipper noise.
+ * 
  * @param[in] voice_id     The ID of the voice.
  * @param[in] left_volume  The new left volume of the voice, valid between -1.0 and 1.0.
  * @param[in] right_volume The new right volume of the voice, valid between -1.0 and 1.0.
@@ -599,6 +944,26 @@ s32 ansnd_stop_looping(u32 voice_id);
  */
 s32 ansnd_set_voice_volume(u32 voice_id, f32 left_volume, f32 right_volume);
 
+/**
+ * @brief Ramps the volume of a voice to a new value over a period of time.
+ * 
+ * The DSP steps the volume every output sample, so no further calls are needed to produce a smooth fade.
+ * Calling this again during a ramp starts a new ramp from the current volume.
+ * 
+ * @param[in] voice_id     The ID of the voice.
+ * @param[in] left_volume  The target left volume of the voice, valid between -1.0 and 1.0.
+ * @param[in] right_volume The target right volume of the voice, valid between -1.0 and 1.0.
+ * @param[in] ramp_time    The duration of the ramp in microseconds, rounded up to a whole number of processing cycles.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_volume_ramp(u32 voice_id, f32 left_volume, f32 right_volume, u32 ramp_time);
+
 /**
  * @brief Sets the pitch of a voice.
  * 
@@ -614,6 +979,8 @@ s32 ansnd_set_voice_volume(u32 voice_id, f32 left_volume, f32 right_volume);
  * (pitch * samplerate) <= ANSND_MAX_SAMPLERATE_96KHZ
  * @endcode
  * 
+ * The pitch can be changed while the voice is running, the resampler history is kept so the change is seamless.
+ * 
  * @param[in] voice_id The ID of the voice.
  * @param[in] pitch    The new pitch of the voice, default is 1.0.
  * 
@@ -621,13 +988,285 @@ s32 ansnd_set_voice_volume(u32 voice_id, f32 left_volume, f32 right_volume);
  * @return May return @ref ANSND_ERROR_INVALID_INPUT.
  * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
  * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
- * @return May return @ref ANSND_ERROR_VOICE_RUNNING.
  * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
  * 
  * @ingroup voices
  */
 s32 ansnd_set_voice_pitch(u32 voice_id, f32 pitch);
 
+/**
+ * @brief Glides the pitch of a voice to a new value over time.
+ * 
+ * The DSP steps the pitch once per processing cycle, starting from the pitch the voice is currently playing at.  
+ * A glide started before the voice is first played takes effect immediately.  
+ * The same samplerate limits as @ref ansnd_set_voice_pitch apply to the target pitch.
+ * 
+ * @param[in] voice_id   The ID of the voice.
+ * @param[in] pitch      The target pitch of the voice.
+ * @param[in] glide_time The duration of the glide in microseconds, rounded up to a whole number of processing cycles.
+ * @param[in] glide_mode The [glide mode](@ref glide_modes).
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_glide_voice_pitch(u32 voice_id, f32 pitch, u32 glide_time, u8 glide_mode);
+
+/**
+ * @brief Sets the LFO of a voice for vibrato and tremolo.
+ * 
+ * The LFO is evaluated by the DSP once per processing cycle and modulates the pitch and volume of the voice 
+ * without resetting its resampling history.  
+ * Use @ref ANSND_LFO_SHAPE_OFF to disable the LFO.
+ * 
+ * @param[in] voice_id     The ID of the voice.
+ * @param[in] shape        The [LFO shape](@ref lfo_shapes).
+ * @param[in] rate         The LFO rate in Hz, valid up to 100 Hz at 48 kHz output or ~66 Hz at 32 kHz output.
+ * @param[in] pitch_depth  The peak pitch deviation in semitones, valid between 0.0 and 12.0.
+ * @param[in] volume_depth The peak volume reduction, valid between 0.0 and 1.0.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_INVALID_SAMPLERATE.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_lfo(u32 voice_id, u8 shape, f32 rate, f32 pitch_depth, f32 volume_depth);
+
+/**
+ * @brief Sets the biquad filter of a voice.
+ * 
+ * The filter is run by the DSP on every output sample after resampling, its history is kept across changes 
+ * so the cutoff can be swept while the voice is running.  
+ * Use @ref ANSND_BIQUAD_TYPE_OFF to disable the filter, in which case @p cutoff and @p q are ignored.
+ * 
+ * @note
+ * The coefficients and filter state are kept to 32 bits, so the response holds down to the lowest cutoff, 
+ * though below about 20 Hz rounding leaves an error of a few dozen LSBs on full scale signals.
+ * 
+ * @param[in] voice_id The ID of the voice.
+ * @param[in] type     The [biquad filter type](@ref biquad_types).
+ * @param[in] cutoff   The cutoff or center frequency in Hz, valid between 10 Hz and 45% of the output samplerate.
+ * @param[in] q        The quality factor of the filter, valid between 0.1 and 20.0, 0.7071 gives a flat passband.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_biquad(u32 voice_id, u8 type, f32 cutoff, f32 q);
+
+/**
+ * @brief Sets the resample quality of a voice.
+ * 
+ * Voices that are not played at the output samplerate are resampled by the DSP, by default with a windowed sinc filter 
+ * that gets longer as the voice is pitched down.  
+ * The cheaper qualities take less DSP time for every resampled voice and don't filter when pitching down, 
+ * which suits sounds where aliasing goes unnoticed.
+ * 
+ * @note
+ * @ref ANSND_RESAMPLE_QUALITY_CUBIC runs from a coefficient table that the CPU builds once for the voice, 
+ * whether or not @ref ansnd_set_resample_tables is enabled, so the first cubic voice allocates the tables.  
+ * The quality is reset to @ref ANSND_RESAMPLE_QUALITY_SINC whenever the voice is configured.
+ * 
+ * @param[in] voice_id The ID of the voice.
+ * @param[in] quality  The [resample quality](@ref resample_qualities).
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * @return May return @ref ANSND_ERROR_OUT_OF_MEMORY.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_resample_quality(u32 voice_id, u8 quality);
+
+/**
+ * @brief Sets how much of a voice is sent to an aux bus.
+ * 
+ * The DSP mixes the voice into the aux bus after its volume, envelope and filter, 
+ * the aux bus is then handed to its [aux callback](@ref ansnd_aux_callback_t) every cycle.
+ * 
+ * @param[in] voice_id   The ID of the voice.
+ * @param[in] aux_bus    The aux bus, valid between 0 and @ref ANSND_MAX_AUX_BUSES - 1.
+ * @param[in] send_level The send level, valid between 0.0 and 1.0, default is 0.0.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_aux_send(u32 voice_id, u8 aux_bus, f32 send_level);
+
+/**
+ * @brief Assigns a voice to a mix group.
+ * 
+ * @param[in] voice_id The ID of the voice.
+ * @param[in] group    The mix group, valid between 0 and @ref ANSND_MAX_GROUPS - 1, default is @ref ANSND_GROUP_MASTER.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_group(u32 voice_id, u8 group);
+
+/**
+ * @brief Enables metering of a voice.
+ * 
+ * The DSP measures the peak and RMS level of a metered voice every cycle, after its filter and before its volume.  
+ * Metering adds to the time the DSP spends on the voice, so only enable it where the levels are used.
+ * 
+ * @param[in] voice_id The ID of the voice.
+ * @param[in] enabled  Whether the voice is metered, default is false.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * @return May return @ref ANSND_ERROR_VOICE_NOT_CONFIGURED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_set_voice_metering(u32 voice_id, bool enabled);
+
+/**
+ * @brief Gets the levels of a metered voice measured during the last cycle.
+ * 
+ * Both levels are relative to full scale, stereo voices are measured over both channels.  
+ * Voices that are not metered or did not play during the last cycle read as 0.0.
+ * 
+ * @param[in]  voice_id The ID of the voice.
+ * @param[out] peak     The peak level, between 0.0 and 1.0, may be NULL.
+ * @param[out] rms      The RMS level, between 0.0 and 1.0, may be NULL.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_VOICE_ID_NOT_ALLOCATED.
+ * 
+ * @ingroup voices
+ */
+s32 ansnd_get_voice_meter(u32 voice_id, f32* peak, f32* rms);
+
+/**
+ * @brief Nests a mix group under another.
+ * 
+ * The volume, mute and pause of the parent group also apply to every voice in the nested group.  
+ * To rule out cycles, the parent group must have a lower index than the group.
+ * 
+ * @param[in] group        The mix group, valid between 1 and @ref ANSND_MAX_GROUPS - 1.
+ * @param[in] parent_group The new parent of the group, default is @ref ANSND_GROUP_MASTER.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_set_group_parent(u8 group, u8 parent_group);
+
+/**
+ * @brief Sets the volume of a mix group.
+ * 
+ * The DSP applies the group volume on top of the volume of each voice, ramping to it over one cycle.
+ * 
+ * @param[in] group  The mix group.
+ * @param[in] volume The new volume of the group, valid between 0.0 and 1.0, default is 1.0.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_set_group_volume(u8 group, f32 volume);
+
+/**
+ * @brief Mutes a mix group.
+ * 
+ * Voices in a muted group keep playing silently.
+ * 
+ * @param[in] group The mix group.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_mute_group(u8 group);
+
+/**
+ * @brief Unmutes a mix group.
+ * 
+ * @param[in] group The mix group.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_unmute_group(u8 group);
+
+/**
+ * @brief Pauses a mix group.
+ * 
+ * The DSP skips voices in a paused group, their own state is left untouched.
+ * 
+ * @param[in] group The mix group.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_pause_group(u8 group);
+
+/**
+ * @brief Unpauses a mix group.
+ * 
+ * @param[in] group The mix group.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_unpause_group(u8 group);
+
+/**
+ * @brief Sets a mix group to be ducked by another.
+ * 
+ * While the key group is louder than @p threshold, the ducked group is turned down to @p ducked_volume, 
+ * and turned back up once the key group is quiet again.  
+ * The level of the key group is the highest RMS level of its metered voices and those of the groups below it, 
+ * so enable metering on those voices with @ref ansnd_set_voice_metering.  
+ * The ducking is updated once per cycle and applied on top of the group volume.
+ * 
+ * @param[in] group         The mix group that is ducked.
+ * @param[in] enabled       Whether the group is ducked.
+ * @param[in] key_group     The mix group that triggers the ducking, must be different from @p group.
+ * @param[in] ducked_volume The volume of the group while ducked, valid between 0.0 and 1.0.
+ * @param[in] threshold     The RMS level of the key group that triggers the ducking, valid between 0.0 and 1.0 of full scale.
+ * @param[in] attack_time   The time constant of turning the group down, in microseconds.
+ * @param[in] release_time  The time constant of turning the group back up, in microseconds.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup groups
+ */
+s32 ansnd_set_group_ducking(u8 group, bool enabled, u8 key_group, f32 ducked_volume, f32 threshold, u32 attack_time, u32 release_time);
+
 /**
  * @brief Gets the DSP processing time.
  * 
@@ -674,6 +1313,167 @@ s32 ansnd_get_total_usage_percent(f32* total_usage);
  */
 s32 ansnd_get_total_active_voices(u32* active_voices);
 
+/**
+ * @brief Gets the total number of virtual voices.
+ * 
+ * Virtual voices are active voices that are too quiet to be heard, see @ref ansnd_set_virtualization.  
+ * They are included in the number of active voices.
+ * 
+ * @param[out] virtual_voices The number of virtual voices, may be NULL.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_get_total_virtual_voices(u32* virtual_voices);
+
+/**
+ * @brief Sets voice virtualization.
+ * 
+ * While virtualization is enabled, a playing voice whose volume, including its mix group, is at or below @p threshold 
+ * is no longer processed by the DSP.  
+ * Its position is moved along on the CPU instead, following loops and finishing where it would have, 
+ * and the voice picks up from there once it is audible again.  
+ * This frees DSP time for the voices that can be heard.
+ * 
+ * @note
+ * Voices that are streaming, delayed, gliding, releasing, or linked are not virtualized.  
+ * Envelopes and LFOs hold their state while a voice is virtual.  
+ * ADPCM voices resume from the start of the frame they reached.
+ * 
+ * @param[in] enabled   Whether voices are virtualized.
+ * @param[in] threshold The volume at or below which a voice is virtualized, valid between 0.0 and 1.0.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_set_virtualization(bool enabled, f32 threshold);
+
+/**
+ * @brief Sets resampling from coefficient tables.
+ * 
+ * By default the DSP calculates the resampling coefficients for every output sample of a voice that is resampled.  
+ * With coefficient tables, the CPU builds a table for each resampled voice whenever its pitch changes 
+ * and the DSP looks the coefficients up instead, which takes less DSP time for every voice that is not played at its own samplerate.
+ * 
+ * @note
+ * Building a table takes some CPU time in the DSP interrupt, so it is skipped while a voice glides.  
+ * The tables hold @p phases phases for the usual 4 coefficients, and fewer as more are needed when pitching down.  
+ * They take 16 bytes per phase for each of the @ref ANSND_MAX_VOICES voices, 96 KB at 128 phases, 
+ * and are only allocated the first time they are enabled or a voice uses @ref ANSND_RESAMPLE_QUALITY_CUBIC.  
+ * Changing the phase count of allocated tables reallocates them, waiting for the DSP to finish its current cycle.  
+ * If it does not finish, the old tables are kept until it has, and the phase count cannot change again before then.
+ * 
+ * @param[in] enabled Whether resampled voices use coefficient tables.
+ * @param[in] phases  The number of phases in a table, one of 16, 32, 64 or 128, fewer phases take less memory and DMA time.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_OUT_OF_MEMORY.
+ * @return May return @ref ANSND_ERROR_DSP_STALLED.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_set_resample_tables(bool enabled, u16 phases);
+
+/**
+ * @brief Sets the wide mix mode.
+ * 
+ * By default every voice is mixed straight into the 16-bit output, saturating after each voice, 
+ * so loud overlapping voices clip in an order dependent way.  
+ * In the wide mix mode voices are accumulated with 32 bits of precision instead, 
+ * and the sum is scaled by @p master_gain and saturated once when the buffer is sent.  
+ * This costs the DSP some time per voice and per buffer.
+ * 
+ * @note
+ * Aux buses are not affected and still saturate per voice.
+ * 
+ * @param[in] enabled     Whether the wide mix is enabled.
+ * @param[in] master_gain The gain applied to the wide mix before saturating, valid between 0.0 and 1.0.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_set_wide_mix(bool enabled, f32 master_gain);
+
+/**
+ * @brief Sets how voice and stream callbacks are called.
+ * 
+ * By default voice state callbacks and stream data callbacks are called from the DSP interrupt, 
+ * so the time they take delays the next cycle and every other interrupt.  
+ * In the polled and thread modes they are queued from the interrupt instead 
+ * and called later from @ref ansnd_dispatch_callbacks or from a library thread.
+ * 
+ * Stream data is requested as soon as a stream has room for another buffer, 
+ * which leaves the length of the buffer already queued on the DSP to deliver it.  
+ * A stream that is not refilled in time finishes, as it does when its callback returns no data.
+ * 
+ * @note
+ * The audio buffer and aux bus callbacks still run in the interrupt, since they work on the buffer being sent out.  
+ * Should the queue ever fill up, callbacks are called from the interrupt until there is room again.
+ * 
+ * @param[in] mode            The [callback mode](@ref callback_modes).
+ * @param[in] thread_priority The priority of the callback thread in @ref ANSND_CALLBACK_MODE_THREAD, valid between 0 and 127.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * @return May return @ref ANSND_ERROR_THREAD_FAILED.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_set_callback_mode(u8 mode, u8 thread_priority);
+
+/**
+ * @brief Calls the queued voice and stream callbacks.
+ * 
+ * Only does anything in @ref ANSND_CALLBACK_MODE_POLLED, where it should be called at least once per cycle, 
+ * from a single thread.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_dispatch_callbacks();
+
+/**
+ * @brief Sets the master limiter.
+ * 
+ * The limiter runs on the CPU over the final mix, after the aux bus callbacks and before the audio buffer callback.  
+ * It looks ahead ~1 ms, so peaks are turned down smoothly instead of clipping, at the cost of delaying the output by the same amount.  
+ * Its cost per buffer is fixed, regardless of how many voices are playing.
+ * 
+ * @note
+ * The mix reaching the limiter has already been saturated to 16 bits, 
+ * so leave headroom in the voice volumes or with the master gain of the wide mix, see @ref ansnd_set_wide_mix, 
+ * and make it up with @p input_gain.
+ * 
+ * @param[in] enabled      Whether the limiter is enabled.
+ * @param[in] input_gain   The gain applied to the mix before limiting, valid between 1.0 and 16.0.
+ * @param[in] threshold    The highest output level, valid between 0.0 and 1.0 of full scale.
+ * @param[in] release_time The time constant of the gain recovering after a peak, in microseconds.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_set_limiter(bool enabled, f32 input_gain, f32 threshold, u32 release_time);
+
+/**
+ * @brief Gets the gain reduction of the master limiter.
+ * 
+ * @param[out] gain_reduction The largest gain reduction applied during the last cycle in decibels, 0.0 when not limiting, may be NULL.
+ * 
+ * @return May return @ref ANSND_ERROR_NOT_INITIALIZED.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_get_limiter_gain_reduction(f32* gain_reduction);
+
 /**
  * @brief Audio buffer callback type.
  * 
@@ -714,6 +1514,50 @@ typedef void (*ansnd_audio_callback_t) (void* audio_buffer, u32 buffer_length, v
  */
 s32 ansnd_register_audio_callback(ansnd_audio_callback_t callback, void* callback_arguments);
 
+/**
+ * @brief Aux bus callback type.
+ * 
+ * This is the function pointer type for processing an aux bus, 
+ * such as running a reverb and adding its output to the audio buffer.
+ * 
+ * @attention
+ * The format of both buffers is Right-Left interleaved Big-Endian Signed 16-bit PCM.
+ * 
+ * @note
+ * Aux callbacks run before the audio buffer callback, changes made to the audio buffer will be reflected in the final output.
+ * 
+ * An aux bus callback has the following signature:
+ * @code
+ * void callback_name(u8 aux_bus, void* aux_buffer, void* audio_buffer, u32 buffer_length, void* callback_arguments)
+ * @endcode
+ * 
+ * @param[in] aux_bus            The aux bus being processed.
+ * @param[in] aux_buffer         The pointer to the first byte of the aux bus buffer.
+ * @param[in] audio_buffer       The pointer to the first byte of the audio buffer.
+ * @param[in] buffer_length      The length of both buffers in bytes.
+ * @param[in] callback_arguments The pointer that was supplied to @ref ansnd_register_aux_callback.
+ * 
+ * @ingroup non-voices
+ */
+typedef void (*ansnd_aux_callback_t) (u8 aux_bus, void* aux_buffer, void* audio_buffer, u32 buffer_length, void* callback_arguments);
+
+/**
+ * @brief Sets the callback of an aux bus.
+ * 
+ * This function sets the aux bus callback, 
+ * which is called after the DSP has finished mixing the aux bus.
+ * 
+ * @param[in] aux_bus            The aux bus, valid between 0 and @ref ANSND_MAX_AUX_BUSES - 1.
+ * @param[in] callback           The new [aux bus callback](@ref ansnd_aux_callback_t), NULL discards the aux bus.
+ * @param[in] callback_arguments A pointer that will be supplied to the new callback.
+ * 
+ * @return May return @ref ANSND_ERROR_OK.
+ * @return May return @ref ANSND_ERROR_INVALID_INPUT.
+ * 
+ * @ingroup non-voices
+ */
+s32 ansnd_register_aux_callback(u8 aux_bus, ansnd_aux_callback_t callback, void* callback_arguments);
+
 #ifdef __cplusplus
 }
 #endif
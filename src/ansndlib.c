@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <malloc.h>
 #include <math.h>
 #include <ogcsys.h>
 #include <gccore.h>
@@ -40,9 +41,18 @@
 //
 
 #define MAX_PARAMETER_BLOCKS        ANSND_MAX_VOICES
-#define PARAMETER_BLOCK_STRUCT_SIZE 128
+#define PARAMETER_BLOCK_STRUCT_SIZE 256
 #define DSP_DRAM_SIZE               8192
+#define MIX_TABLE_STRUCT_SIZE       64
+#define COMMAND_BLOCK_STRUCT_SIZE   192
+#define COMMAND_BLOCK_VERSION       0x0002 // must match the DSP, bumped whenever the layout changes
+#define RESAMPLE_TABLE_SIZE         2048 // largest table of a voice in bytes, as much as the DSP has room for
+#define RESAMPLE_TABLE_ROW_SIZE     8    // words per phase for the usual 4 coefficients
+#define RESAMPLE_TABLE_MIN_PHASES   16
+#define RESAMPLE_TABLE_MAX_PHASES   ((RESAMPLE_TABLE_SIZE / 2) / RESAMPLE_TABLE_ROW_SIZE)
 #define ANSND_SOUND_BUFFER_SIZE     960 // output 5ms stereo 16-bit sound data at 48kHz
+#define LIMITER_LOOKAHEAD           48  // look-ahead of the master limiter in stereo samples
+#define ANSND_SAMPLES_PER_CYCLE     240
 
 // Values for the DSP Accelerator
 
@@ -62,11 +72,25 @@
 #define DSP_MAIL_END                0x0000DEAD // dsp terminate task
 #define DSP_MAIL_NEXT               0x00001111 // dsp process next set of data
 #define DSP_MAIL_PREPARE            0x00002222 // dsp prepare for next cycle
-#define DSP_MAIL_MM_LOCATION        0x00003333 // cpu send main memory base locations
 #define DSP_MAIL_RESTART            0x00004444 // dsp restart processing cycle
 
 // Voice flags
 
+#define VOICE_FLAG_RESAMPLE_CHANGE  0x10000000
+#define VOICE_FLAG_STREAM_REQUEST   0x08000000
+#define VOICE_FLAG_ONE_SHOT         0x04000000
+#define VOICE_FLAG_VIRTUAL          0x02000000
+#define VOICE_FLAG_FADING           0x01000000
+#define VOICE_FLAG_STOLEN           0x00800000
+#define VOICE_FLAG_METER_CHANGE     0x00400000
+#define VOICE_FLAG_GROUP_CHANGE     0x00200000
+#define VOICE_FLAG_AUX_CHANGE       0x00100000
+#define VOICE_FLAG_GLIDING          0x00080000
+#define VOICE_FLAG_LFO_CHANGE       0x00040000
+#define VOICE_FLAG_RELEASING        0x00020000
+#define VOICE_FLAG_ENVELOPE         0x00010000
+#define VOICE_FLAG_BIQUAD_CHANGE    0x8000
+#define VOICE_FLAG_VOLUME_CHANGE    0x4000
 #define VOICE_FLAG_PITCH_CHANGE     0x2000
 #define VOICE_FLAG_CONFIGURED       0x1000
 #define VOICE_FLAG_USED             0x0800
@@ -82,14 +106,70 @@
 #define VOICE_FLAG_ADPCM            0x0002
 #define VOICE_FLAG_STEREO           0x0001
 
+// Mix group flags
+
+#define GROUP_FLAG_PAUSED           0x0001
+
+// Callback events
+
+#define CALLBACK_EVENT_VOICE_STATE  0
+#define CALLBACK_EVENT_STREAM_DATA  1
+
+#define CALLBACK_EVENT_QUEUE_SIZE   256
+#define CALLBACK_THREAD_STACK_SIZE  (16 * 1024)
+
+// Mix flags
+
+#define MIX_FLAG_WIDE               0x0001
+#define MIX_FLAG_MASTER_GAIN        0x0002
+
+// Envelope states
+
+#define ENVELOPE_STATE_OFF          0x0000
+#define ENVELOPE_STATE_ATTACK       0x0001
+#define ENVELOPE_STATE_DECAY        0x0002
+#define ENVELOPE_STATE_SUSTAIN      0x0003
+#define ENVELOPE_STATE_RELEASE      0x0004
+
 // Conversion helpers
 
 #define HIGH(x)                     ((u16)(((x) & 0xFFFF0000) >> 16))
 #define LOW(x)                      ((u16)((x) & 0x0000FFFF))
 #define SAMPLES_TO_NIBBLES(x)       ((((x) / 14) * 16) + ((x) % 14) + 2)
 
+// voice handles carry the generation of the allocation above the voice index
+#define VOICE_HANDLE(i, g)          ((s32)(((g) << 16) | (i)))
+#define VOICE_HANDLE_INDEX(x)       ((x) & 0x0000FFFF)
+#define VOICE_HANDLE_GENERATION(x)  ((x) >> 16)
+#define VOICE_GENERATION_MASK       0x7FFF
+
+// voice bitmasks keep voice 0 in the top bit, so the next voice is found by counting leading zeros
+#define VOICE_BIT(i)                (0x8000000000000000ULL >> (i))
+
 //
 
+// signed 2.30 fixed point, split into the signed high half and the low half shifted right by 1
+typedef struct ansnd_biquad_coefficient_t {
+	s16 high;
+	u16 low;
+} ansnd_biquad_coefficient_t;
+
+typedef struct ansnd_biquad_coefficients_t {
+	ansnd_biquad_coefficient_t b0;
+	ansnd_biquad_coefficient_t b1;
+	ansnd_biquad_coefficient_t b2;
+	ansnd_biquad_coefficient_t a1;
+	ansnd_biquad_coefficient_t a2;
+} ansnd_biquad_coefficients_t;
+
+// transposed direct form II state, with 16 fractional bits in the low halves
+typedef struct ansnd_biquad_state_t {
+	s16 s1_high;
+	u16 s1_low;
+	s16 s2_high;
+	u16 s2_low;
+} ansnd_biquad_state_t;
+
 typedef struct ansnd_parameter_block_t {
 	s16 sample_buffer[16];                    // 0x00
 	
@@ -160,32 +240,187 @@ typedef struct ansnd_parameter_block_t {
 			s16 next_buffer_sample_history_2; // 0x3F
 		} streaming;
 	};
+	
+	u16 volume_ramp_cycles;                   // 0x40
+	
+	u16 right_volume_low;                     // 0x41
+	s16 right_volume_delta_high;              // 0x42
+	u16 right_volume_delta_low;               // 0x43
+	u16 left_volume_low;                      // 0x44
+	s16 left_volume_delta_high;               // 0x45
+	u16 left_volume_delta_low;                // 0x46
+	
+	s16 right_volume_target;                  // 0x47
+	s16 left_volume_target;                   // 0x48
+	
+	u16 envelope_state;                       // 0x49
+	u16 envelope_level_high;                  // 0x4A
+	u16 envelope_level_low;                   // 0x4B
+	u16 envelope_attack_high;                 // 0x4C
+	u16 envelope_attack_low;                  // 0x4D
+	u16 envelope_decay_high;                  // 0x4E
+	u16 envelope_decay_low;                   // 0x4F
+	s16 envelope_sustain;                     // 0x50
+	u16 envelope_release_high;                // 0x51
+	u16 envelope_release_low;                 // 0x52
+	
+	s16 gain;                                 // 0x53
+	
+	u16 lfo_shape;                            // 0x54
+	u16 lfo_phase;                            // 0x55
+	u16 lfo_phase_step;                       // 0x56
+	s16 lfo_pitch_depth;                      // 0x57
+	s16 lfo_volume_depth;                     // 0x58
+	
+	u16 glide_cycles;                         // 0x59
+	u16 glide_mode;                           // 0x5A
+	u16 glide_delta_high;                     // 0x5B
+	u16 glide_delta_low;                      // 0x5C
+	u16 glide_target_high;                    // 0x5D
+	u16 glide_target_low;                     // 0x5E
+	
+	u16 biquad_type;                          // 0x5F
+	ansnd_biquad_coefficients_t biquad_coefficients; // 0x60
+	ansnd_biquad_state_t biquad_right;        // 0x6A
+	ansnd_biquad_state_t biquad_left;         // 0x6E
+	
+	s16 aux_send[ANSND_MAX_AUX_BUSES];        // 0x72
+	
+	u16 group;                                // 0x74
+	
+	u16 meter;                                // 0x75
+	u16 meter_peak;                           // 0x76
+	u16 meter_power_high;                     // 0x77
+	u16 meter_power_low;                      // 0x78
+	u16 meter_samples;                        // 0x79
+	
+	u16 resample_table_mask;                  // 0x7A
+	u16 resample_table_high;                  // 0x7B
+	u16 resample_table_low;                   // 0x7C
+	
+	u16 resample_quality;                     // 0x7D
+	
+	u16 padding_2[2];                         // 0x7E
 } ansnd_parameter_block_t;
 
 _Static_assert(sizeof(ansnd_parameter_block_t) == PARAMETER_BLOCK_STRUCT_SIZE, "Struct does not match expected size.");
 
+// mix group state as read by the DSP, with the parent groups already applied
+typedef struct ansnd_group_entry_t {
+	s16 volume;
+	u16 flags;
+} ansnd_group_entry_t;
+
+// mix state fetched by the DSP once per cycle
+typedef struct ansnd_mix_table_t {
+	ansnd_group_entry_t groups[ANSND_MAX_GROUPS]; // 0x00
+	
+	s16 master_gain;                              // 0x10
+	u16 flags;                                    // 0x11
+	
+	u16 padding[14];                              // 0x12
+} ansnd_mix_table_t;
+
+_Static_assert(sizeof(ansnd_mix_table_t) == MIX_TABLE_STRUCT_SIZE, "Struct does not match expected size.");
+
+// everything the DSP needs for a cycle besides the parameter blocks, fetched in a single DMA at its start
+typedef struct ansnd_command_block_t {
+	u16 version;                              // 0x00
+	u16 voice_count;                          // 0x01
+	
+	// only read when the task starts
+	u32 parameter_blocks;                     // 0x02
+	u32 audio_buffers[2];                     // 0x04
+	u32 aux_buffers;                          // 0x08
+	
+	// size in bytes of every resampling table, and the shift that spreads the fraction over its words
+	u16 resample_table_size;                  // 0x0A
+	s16 resample_table_shift;                 // 0x0B
+	
+	u16 padding[4];                           // 0x0C
+	
+	ansnd_mix_table_t mix_table;              // 0x10
+	
+	u16 voices[MAX_PARAMETER_BLOCKS];         // 0x30
+} ansnd_command_block_t;
+
+_Static_assert(sizeof(ansnd_command_block_t) == COMMAND_BLOCK_STRUCT_SIZE, "Struct does not match expected size.");
+
+typedef struct ansnd_limiter_t {
+	bool enabled;
+	f32  input_gain;
+	f32  threshold;
+	f32  release_coefficient;
+	
+	f32  release_gain;
+	f32  smoothing_window[LIMITER_LOOKAHEAD];
+	f32  smoothing_sum;
+	
+	// sliding minimum of the required gain, kept as a monotonic queue
+	f32  minimum_gains[LIMITER_LOOKAHEAD];
+	u32  minimum_positions[LIMITER_LOOKAHEAD];
+	u32  minimum_head;
+	u32  minimum_count;
+	
+	s16  delay_line[LIMITER_LOOKAHEAD][2];
+	u32  slot;
+	u32  position;
+	
+	f32  gain_reduction;
+} ansnd_limiter_t;
+
+// kept across configurations of the voice
+typedef struct ansnd_voice_allocation_t {
+	u8  priority;
+	u8  voice_class;
+	u32 order;
+} ansnd_voice_allocation_t;
+
+typedef struct ansnd_group_t {
+	f32  volume;
+	u8   parent_group;
+	bool muted;
+	bool paused;
+	
+	bool ducking;
+	u8   key_group;
+	f32  ducked_volume;
+	f32  threshold;
+	f32  attack_coefficient;
+	f32  release_coefficient;
+	f32  duck_gain;
+} ansnd_group_t;
+
 typedef union {
 	ansnd_pcm_stream_data_callback_t   pcm_callback;
 	ansnd_adpcm_stream_data_callback_t adpcm_callback;
 } ansnd_stream_data_callback_t;
 
-typedef struct ansnd_voice_t {
+// voice state only needed when the voice is configured or changed through the API
+typedef struct ansnd_voice_setup_t {
 	u32 samplerate;
 	f32 pitch;
+	u32 glide_time;
+	u8  glide_mode;
 	
-	u32 delay;
+	u32 volume_ramp_time;
 	
-	u16 flags;
+	ansnd_envelope_t envelope;
 	
-	f32 left_volume;
-	f32 right_volume;
+	f32 lfo_rate;
+	f32 lfo_pitch_depth;
+	f32 lfo_volume_depth;
+	
+	f32 biquad_cutoff;
+	f32 biquad_q;
+	
+	f32 aux_send[ANSND_MAX_AUX_BUSES];
 	
 	u16 decode_coefficients[16];
 	
 	u16 accelerator_format;
 	u16 accelerator_gain;
 	
-	u32 ram_buffer_start;
 	u32 ram_buffer_end;
 	u32 ram_buffer_first;
 	
@@ -193,28 +428,61 @@ typedef struct ansnd_voice_t {
 	u16 initial_sample_history_1;
 	u16 initial_sample_history_2;
 	
-	union {
-		struct {
-			u32 loop_start;
-			u32 loop_end;
-			
-			u16 loop_predictor_scale;
-			u16 loop_sample_history_1;
-			u16 loop_sample_history_2;
-		} looping;
-		struct {
-			u32 next_buffer_start;
-			u32 next_buffer_end;
-			u32 next_buffer_first;
-			
-			u16 next_buffer_predictor_scale;
-			u16 next_buffer_sample_history_1;
-			u16 next_buffer_sample_history_2;
-		} streaming;
-	};
+	struct {
+		u32 loop_start;
+		u32 loop_end;
+		
+		u16 loop_predictor_scale;
+		u16 loop_sample_history_1;
+		u16 loop_sample_history_2;
+	} looping;
+} ansnd_voice_setup_t;
+
+// voice state the request callback goes through every cycle, kept to a few cache lines
+typedef struct ansnd_voice_t {
+	ansnd_voice_allocation_t allocation;
+	
+	u32 flags;
+	
+	u32 delay;
+	
+	f32 left_volume;
+	f32 right_volume;
+	
+	u8  lfo_shape;
+	u8  biquad_type;
+	u8  resample_quality;
+	u8  group;
+	
+	bool metering;
+	f32  meter_peak;
+	f32  meter_rms;
+	
+	// samples from the start of the voice data in 16.16 fixed point, while virtual
+	u64 virtual_position;
+	
+	u32 ram_buffer_start;
+	
+	struct {
+		u32 next_buffer_start;
+		u32 next_buffer_end;
+		u32 next_buffer_first;
+		
+		u16 next_buffer_predictor_scale;
+		u16 next_buffer_sample_history_1;
+		u16 next_buffer_sample_history_2;
+		
+		// bumped on every request and restart, a queued buffer is only taken if it still matches
+		u32 request_sequence;
+	} streaming;
+	
+	ansnd_voice_setup_t*     setup;
 	
 	ansnd_parameter_block_t* parameter_block;
 	
+	// set for voices configured from a template
+	const ansnd_parameter_block_t* parameter_block_image;
+	
 	struct ansnd_voice_t*    linked_voice;
 	
 	ansnd_voice_callback_t   voice_callback;
@@ -224,8 +492,31 @@ typedef struct ansnd_voice_t {
 	void* user_pointer;
 } ansnd_voice_t;
 
+// a callback raised in the interrupt, with everything it needs captured at that point
+typedef struct ansnd_callback_event_t {
+	u8  type;
+	s32 voice_id;
+	s32 voice_state;
+	bool adpcm;
+	u32 request_sequence;
+	
+	ansnd_voice_callback_t       voice_callback;
+	ansnd_stream_data_callback_t stream_callback;
+	
+	void* user_pointer;
+} ansnd_callback_event_t;
+
+// a validated configuration with its voice state and parameter block already worked out
+typedef struct ansnd_voice_template_t {
+	bool                    used;
+	ansnd_voice_t           voice;
+	ansnd_voice_setup_t     setup;
+	ansnd_parameter_block_t parameter_block;
+} ansnd_voice_template_t;
+
 static dsptask_t              ansnd_dsp_task;
 static u8                     ansnd_dsp_dram_image[DSP_DRAM_SIZE] ATTRIBUTE_ALIGN(32);
+static ansnd_parameter_block_t ansnd_parameter_blocks[MAX_PARAMETER_BLOCKS] ATTRIBUTE_ALIGN(32);
 
 static ansnd_audio_callback_t ansnd_audio_callback           = NULL;
 static void*                  ansnd_audio_callback_arguments = NULL;
@@ -233,6 +524,10 @@ static void*                  ansnd_audio_callback_arguments = NULL;
 static u8 ansnd_next_audio_buffer     = 0;
 static u8 ansnd_audio_buffer_out[2][ANSND_SOUND_BUFFER_SIZE] ATTRIBUTE_ALIGN(32);
 static u8 ansnd_mute_buffer_out[ANSND_SOUND_BUFFER_SIZE] ATTRIBUTE_ALIGN(32);
+static u8 ansnd_aux_buffer_out[ANSND_MAX_AUX_BUSES][ANSND_SOUND_BUFFER_SIZE] ATTRIBUTE_ALIGN(32);
+
+static ansnd_aux_callback_t ansnd_aux_callbacks[ANSND_MAX_AUX_BUSES]          = { NULL };
+static void*                ansnd_aux_callback_arguments[ANSND_MAX_AUX_BUSES] = { NULL };
 
 static u8 ansnd_output_samplerate     = ANSND_OUTPUT_SAMPLERATE_48KHZ;
 
@@ -242,13 +537,66 @@ static bool ansnd_dsp_done_mixing     = false;
 static bool ansnd_dsp_stalled         = false;
 static bool ansnd_dsp_yielding        = false;
 
+static volatile u32 ansnd_dsp_cycles  = 0;
+
 static u32 ansnd_active_voices        = 0;
+static u32 ansnd_virtual_voices       = 0;
 static u64 ansnd_dsp_start_time       = 0;
 static u64 ansnd_dsp_process_time     = 0;
 static u64 ansnd_total_start_time     = 0;
 static u64 ansnd_total_process_time   = 0;
 
-static ansnd_voice_t ansnd_voices[ANSND_MAX_VOICES];
+static ansnd_voice_t       ansnd_voices[ANSND_MAX_VOICES];
+static ansnd_voice_setup_t ansnd_voice_setups[ANSND_MAX_VOICES];
+
+// the voices the request callback visits, so idle voices are never touched
+static u64 ansnd_updated_voices = 0;
+static u64 ansnd_running_voices = 0;
+
+static ansnd_voice_template_t ansnd_voice_templates[ANSND_MAX_VOICE_TEMPLATES];
+
+static u32 ansnd_voice_class_limits[ANSND_MAX_VOICE_CLASSES];
+static u32 ansnd_voice_class_counts[ANSND_MAX_VOICE_CLASSES];
+static u32 ansnd_allocation_count = 0;
+
+// not reset on initialization, so handles from before stay invalid
+static u16 ansnd_voice_generations[ANSND_MAX_VOICES];
+
+// stack of unused voice indices
+static u8  ansnd_free_voices[ANSND_MAX_VOICES];
+static u32 ansnd_free_voice_count = 0;
+
+static ansnd_limiter_t ansnd_limiter;
+
+static ansnd_group_t     ansnd_groups[ANSND_MAX_GROUPS];
+static ansnd_command_block_t ansnd_command_block ATTRIBUTE_ALIGN(32);
+
+static bool ansnd_wide_mix    = false;
+static f32  ansnd_master_gain = 1.f;
+
+// single producer queue, filled by the interrupt and drained by one dispatcher
+static u8                     ansnd_callback_mode = ANSND_CALLBACK_MODE_IMMEDIATE;
+static ansnd_callback_event_t ansnd_callback_events[CALLBACK_EVENT_QUEUE_SIZE];
+static volatile u32           ansnd_callback_event_head = 0;
+static volatile u32           ansnd_callback_event_tail = 0;
+
+static lwp_t         ansnd_callback_thread      = LWP_THREAD_NULL;
+static lwpq_t        ansnd_callback_queue       = LWP_TQUEUE_NULL;
+static volatile bool ansnd_callback_thread_quit = false;
+
+// one resampling coefficient table per voice, rebuilt when the filter step of the voice changes
+// they are only allocated once a voice needs one, ansnd_resample_table_size bytes for each voice
+static s16* ansnd_resample_tables         = NULL;
+static u32  ansnd_resample_table_size     = RESAMPLE_TABLE_SIZE;
+static u32  ansnd_resample_table_phases   = RESAMPLE_TABLE_MAX_PHASES;
+static s16* ansnd_retired_resample_tables = NULL;
+static u32  ansnd_retired_resample_cycle  = 0;
+static u16  ansnd_resample_table_steps[MAX_PARAMETER_BLOCKS];
+static u8   ansnd_resample_table_qualities[MAX_PARAMETER_BLOCKS];
+static bool ansnd_resample_tables_enabled = false;
+
+static bool ansnd_virtualization           = false;
+static f32  ansnd_virtualization_threshold = 0.f;
 
 // forward declarations for ansnd_load_dsp_task()
 static void ansnd_dsp_initialized_callback(dsptask_t* task);
@@ -271,14 +619,182 @@ static void ansnd_load_dsp_task() {
 	DSP_AddTask(&ansnd_dsp_task);
 }
 
+static void ansnd_update_mix_table() {
+	f32  volumes[ANSND_MAX_GROUPS];
+	bool paused[ANSND_MAX_GROUPS];
+	
+	// parents always have a lower index, so they are resolved first
+	for (u32 i = 0; i < ANSND_MAX_GROUPS; ++i) {
+		ansnd_group_t* group = &ansnd_groups[i];
+		
+		volumes[i] = group->muted ? 0.f : (group->volume * group->duck_gain);
+		paused[i]  = group->paused;
+		if (i != ANSND_GROUP_MASTER) {
+			volumes[i] *= volumes[group->parent_group];
+			paused[i]  |= paused[group->parent_group];
+		}
+		
+		ansnd_command_block.mix_table.groups[i].volume = lrintf(0x7FFF * volumes[i]);
+		ansnd_command_block.mix_table.groups[i].flags  = paused[i] ? GROUP_FLAG_PAUSED : 0;
+	}
+	
+	// unity gain skips the multiply on the DSP, keeping the wide mix bit exact
+	ansnd_command_block.mix_table.master_gain = lrintf(0x7FFF * ansnd_master_gain);
+	ansnd_command_block.mix_table.flags       = 0;
+	if (ansnd_wide_mix) {
+		ansnd_command_block.mix_table.flags |= MIX_FLAG_WIDE;
+		if (ansnd_master_gain != 1.f) {
+			ansnd_command_block.mix_table.flags |= MIX_FLAG_MASTER_GAIN;
+		}
+	}
+	
+	DCFlushRange(&ansnd_command_block.mix_table, MIX_TABLE_STRUCT_SIZE);
+}
+
+static bool ansnd_group_contains(u8 group, u8 member_group) {
+	// parents always have a lower index, so walking up ends at the master group
+	while (member_group != group) {
+		if (member_group == ANSND_GROUP_MASTER) {
+			return false;
+		}
+		member_group = ansnd_groups[member_group].parent_group;
+	}
+	return true;
+}
+
+static void ansnd_update_group_ducking() {
+	bool changed = false;
+	
+	for (u32 i = 0; i < ANSND_MAX_GROUPS; ++i) {
+		ansnd_group_t* group = &ansnd_groups[i];
+		
+		if (!group->ducking) {
+			continue;
+		}
+		
+		// the key level is the loudest metered voice in the key group or below it
+		f32 key_level = 0.f;
+		for (u64 voices = ansnd_running_voices; voices != 0; voices &= ~VOICE_BIT(__builtin_clzll(voices))) {
+			ansnd_voice_t* voice = &ansnd_voices[__builtin_clzll(voices)];
+			
+			if (voice->metering &&
+				(voice->flags & VOICE_FLAG_RUNNING) &&
+				(voice->meter_rms > key_level) &&
+				ansnd_group_contains(group->key_group, voice->group)) {
+				key_level = voice->meter_rms;
+			}
+		}
+		
+		f32 target_gain = (key_level > group->threshold) ? group->ducked_volume : 1.f;
+		f32 coefficient = (target_gain < group->duck_gain) ? group->attack_coefficient : group->release_coefficient;
+		f32 duck_gain   = target_gain + (group->duck_gain - target_gain) * coefficient;
+		
+		// settle on the target instead of approaching it forever
+		if (fabsf(duck_gain - target_gain) < 0.0001f) {
+			duck_gain = target_gain;
+		}
+		
+		if (duck_gain != group->duck_gain) {
+			group->duck_gain = duck_gain;
+			changed = true;
+		}
+	}
+	
+	if (changed) {
+		ansnd_update_mix_table();
+	}
+}
+
+static bool ansnd_push_callback_event(const ansnd_callback_event_t* event) {
+	u32 head = ansnd_callback_event_head;
+	if ((head - ansnd_callback_event_tail) >= CALLBACK_EVENT_QUEUE_SIZE) {
+		return false;
+	}
+	
+	ansnd_callback_events[head % CALLBACK_EVENT_QUEUE_SIZE] = *event;
+	
+	// the event has to be in place before the dispatcher can see it
+	__sync_synchronize();
+	ansnd_callback_event_head = head + 1;
+	return true;
+}
+
+static void ansnd_notify_voice_state(ansnd_voice_t* voice, s32 voice_state) {
+	if (!voice->voice_callback) {
+		return;
+	}
+	
+	if (ansnd_callback_mode != ANSND_CALLBACK_MODE_IMMEDIATE) {
+		u32 voice_index = voice - ansnd_voices;
+		
+		ansnd_callback_event_t event;
+		event.type             = CALLBACK_EVENT_VOICE_STATE;
+		event.voice_id         = VOICE_HANDLE(voice_index, ansnd_voice_generations[voice_index]);
+		event.voice_state      = voice_state;
+		event.adpcm            = false;
+		event.request_sequence = 0;
+		event.voice_callback   = voice->voice_callback;
+		event.stream_callback  = voice->stream_callback;
+		event.user_pointer     = voice->user_pointer;
+		
+		if (ansnd_push_callback_event(&event)) {
+			return;
+		}
+	}
+	
+	voice->voice_callback(voice->user_pointer, voice_state);
+}
+
+static void ansnd_clear_voice(ansnd_voice_t* voice) {
+	ansnd_voice_setup_t* setup = voice->setup;
+	// reconfiguring keeps the handle, so the sequence must move on rather than start over
+	u32 request_sequence = voice->streaming.request_sequence + 1;
+	memset(voice, 0, sizeof(ansnd_voice_t));
+	memset(setup, 0, sizeof(ansnd_voice_setup_t));
+	voice->setup = setup;
+	voice->streaming.request_sequence = request_sequence;
+}
+
 static void ansnd_erase_voice(ansnd_voice_t* voice) {
+	ansnd_voice_class_counts[voice->allocation.voice_class]--;
+	
 	memset(voice->parameter_block, 0, PARAMETER_BLOCK_STRUCT_SIZE);
-	memset(voice, 0, sizeof(ansnd_voice_t));
+	ansnd_clear_voice(voice);
+	
+	ansnd_free_voices[ansnd_free_voice_count++] = voice - ansnd_voices;
 }
 
-static void ansnd_update_voice_pitch(ansnd_voice_t* voice) {
-	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+static void ansnd_mark_voice_updated(ansnd_voice_t* voice) {
+	voice->flags         |= VOICE_FLAG_UPDATED;
+	ansnd_updated_voices |= VOICE_BIT(voice - ansnd_voices);
+}
+
+static bool ansnd_voice_handle_valid(u32 voice_id) {
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
 	
+	// deallocated voices are only erased on the next cycle, their handle is already stale
+	return (voice->flags & VOICE_FLAG_USED) &&
+		!(voice->flags & VOICE_FLAG_ERASED) &&
+		(ansnd_voice_generations[VOICE_HANDLE_INDEX(voice_id)] == VOICE_HANDLE_GENERATION(voice_id));
+}
+
+// the length of one DSP cycle, the audio buffer at the output samplerate
+static u32 ansnd_microseconds_per_cycle() {
+	switch (ansnd_output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		return 7500;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		return 5000;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		return 2500;
+#endif
+	default:
+		return 1;
+	}
+}
+
+static u32 ansnd_calculate_relative_frequency(ansnd_voice_t* voice) {
 	f32 dsp_frequency = 1.f;
 	switch (ansnd_output_samplerate) {
 	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
@@ -297,7 +813,7 @@ static void ansnd_update_voice_pitch(ansnd_voice_t* voice) {
 	}
 	
 	const u32 base_frequency = 0x00010000;
-	f32 adjusted_samplerate  = voice->samplerate * voice->pitch;
+	f32 adjusted_samplerate  = voice->setup->samplerate * voice->setup->pitch;
 	u32 relative_frequency   = lrintf((f32)base_frequency * (adjusted_samplerate / dsp_frequency));
 	
 	// funnel down samplerates that are very close to base already to avoid resampling
@@ -306,41 +822,300 @@ static void ansnd_update_voice_pitch(ansnd_voice_t* voice) {
 		relative_frequency = base_frequency;
 	}
 	
-	parameter_block->relative_frequency_high = HIGH(relative_frequency);
-	parameter_block->relative_frequency_low  = LOW(relative_frequency);
+	// likewise for ratios in half steps like 1:2, 3:2 and 2:1, which the DSP resamples with fixed coefficients
+	u32 half_step_frequency = (relative_frequency + 0x4000) & ~0x7FFF;
+	u32 tolerance = half_step_frequency >> 8;
+	if ((relative_frequency > (half_step_frequency - tolerance)) &&
+		(relative_frequency < (half_step_frequency + tolerance))) {
+		relative_frequency = half_step_frequency;
+	}
+	
+	return relative_frequency;
+}
+
+static void ansnd_resize_sample_buffer(s16* sample_buffer, u32 old_size, u32 new_size, u32 index) {
+	// the circular buffer occupies the last 'size' entries, index points at the oldest sample
+	s16 samples[16];
+	for (u32 i = 0; i < old_size; ++i) {
+		samples[i] = sample_buffer[16 - old_size + ((index - (16 - old_size) + i) % old_size)];
+	}
+	
+	// keep the most recent samples, oldest first, and pad with silence if the buffer grew
+	for (u32 i = 0; i < new_size; ++i) {
+		s32 j = (s32)old_size - (s32)new_size + (s32)i;
+		sample_buffer[16 - new_size + i] = (j >= 0) ? samples[j] : 0;
+	}
+}
+
+static void ansnd_update_voice_filter(ansnd_voice_t* voice, u32 relative_frequency, bool keep_history) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
 	
+	const u32 base_frequency = 0x00010000;
 	u16 filter_step       = 0x7FFF;
 	s16 correction_factor = 32767;
-	if (relative_frequency > base_frequency) {
-		filter_step       = lrintf((f32)base_frequency * (dsp_frequency / adjusted_samplerate) * 0.5f);
+	// only sinc resampling lowers the cutoff when pitching down, the other qualities keep the shortest buffer
+	if ((relative_frequency > base_frequency) &&
+		(voice->resample_quality == ANSND_RESAMPLE_QUALITY_SINC)) {
+		filter_step       = lrintf((f32)base_frequency * ((f32)base_frequency / relative_frequency) * 0.5f);
 		correction_factor = -256 * (128 - (filter_step >> 8)) + 32767;
 	}
 	parameter_block->filter_step       = filter_step;
 	parameter_block->correction_factor = correction_factor;
+	parameter_block->resample_quality  = voice->resample_quality;
 	
 	u16 sample_buffer_size = lrintf(131071.f / filter_step);
+	u16 old_buffer_size    = parameter_block->sample_buffer_wrapping + 1;
+	if (!keep_history) {
+		parameter_block->sample_buffer_index = 16 - sample_buffer_size;
+	} else if (sample_buffer_size != old_buffer_size) {
+		// rearrange the sample history for the new buffer size instead of clearing it
+		ansnd_resize_sample_buffer(parameter_block->sample_buffer, old_buffer_size, sample_buffer_size, parameter_block->sample_buffer_index);
+		if (!(parameter_block->flags & VOICE_FLAG_ADPCM)) {
+			ansnd_resize_sample_buffer(parameter_block->pcm.sample_buffer_2, old_buffer_size, sample_buffer_size, parameter_block->sample_buffer_index);
+		}
+		parameter_block->sample_buffer_index = 16 - sample_buffer_size;
+	}
 	parameter_block->sample_buffer_wrapping = sample_buffer_size - 1;
-	parameter_block->sample_buffer_index    = 16 - sample_buffer_size;
 	
 	parameter_block->filter_step_512 = (filter_step >> 6) & 0x01FC;
 }
 
+static f32 ansnd_sinc(f32 x) {
+	if (fabsf(x) < 1e-6f) {
+		return 1.f;
+	}
+	return sinf((f32)M_PI * x) / ((f32)M_PI * x);
+}
+
+static f32 ansnd_cubic(f32 x) {
+	// catmull-rom spline, passes through the samples either side of the output
+	x = fabsf(x);
+	if (x < 1.f) {
+		return ((1.5f * x - 2.5f) * x) * x + 1.f;
+	}
+	if (x < 2.f) {
+		return ((-0.5f * x + 2.5f) * x - 4.f) * x + 2.f;
+	}
+	return 0.f;
+}
+
+static void ansnd_build_resample_table(u32 voice_index, u8 resample_quality) {
+	ansnd_parameter_block_t* const parameter_block = &ansnd_parameter_blocks[voice_index];
+	s16* const table = &ansnd_resample_tables[voice_index * (ansnd_resample_table_size / 2)];
+	
+	u32 taps = parameter_block->sample_buffer_wrapping + 1;
+	
+	// rows are a power of two long so the DSP finds the row for a phase with a shift and a mask
+	// they are laid out like the coefficient buffer, the DSP loads a pad word after the coefficients and then the error factor
+	u32 row_size = 8;
+	while (row_size < (taps + 2)) {
+		row_size <<= 1;
+	}
+	u32 phases = (ansnd_resample_table_size / 2) / row_size;
+	
+	// lanczos windowed sinc, with the cutoff lowered along with the filter step when pitching down
+	f32 cutoff = parameter_block->filter_step / 32768.f;
+	f32 window = taps * 0.5f;
+	
+	for (u32 phase = 0; phase < phases; ++phase) {
+		s16* row = &table[phase * row_size];
+		
+		// the samples run from oldest to newest, the output falls just past the middle one
+		f32 position = (taps - 1) * 0.5f - 0.5f + (f32)phase / phases;
+		
+		s32 sum = 0;
+		for (u32 i = 0; i < taps; ++i) {
+			f32 x = (f32)i - position;
+			f32 coefficient = 0.f;
+			if (resample_quality == ANSND_RESAMPLE_QUALITY_CUBIC) {
+				coefficient = ansnd_cubic(x);
+			} else if (fabsf(x) < window) {
+				coefficient = cutoff * ansnd_sinc(cutoff * x) * ansnd_sinc(x / window);
+			}
+			
+			s32 fixed_coefficient = lrintf(coefficient * 32767.f);
+			if (fixed_coefficient > 32767) {
+				fixed_coefficient = 32767;
+			} else if (fixed_coefficient < -32768) {
+				fixed_coefficient = -32768;
+			}
+			row[i] = fixed_coefficient;
+			sum   += fixed_coefficient;
+		}
+		
+		// the DSP scales the result by 1 + error factor, which brings the coefficients back to unity gain
+		s32 error_factor = 0;
+		if (sum > 0) {
+			error_factor = lrintf(32768.f * (32767.f / sum - 1.f));
+		}
+		if (error_factor > 32767) {
+			error_factor = 32767;
+		} else if (error_factor < -32768) {
+			error_factor = -32768;
+		}
+		row[taps]     = 0;
+		row[taps + 1] = error_factor;
+	}
+	
+	DCFlushRange(table, ansnd_resample_table_size);
+	
+	u32 table_address = MEM_VIRTUAL_TO_PHYSICAL(table);
+	parameter_block->resample_table_mask = ((ansnd_resample_table_size / 2) - 1) & ~(row_size - 1);
+	parameter_block->resample_table_high = HIGH(table_address);
+	parameter_block->resample_table_low  = LOW(table_address);
+	
+	ansnd_resample_table_steps[voice_index]     = parameter_block->filter_step;
+	ansnd_resample_table_qualities[voice_index] = resample_quality;
+}
+
+// keeps the table of a voice about to be mixed in step with its filter, sinc tables are left out while gliding
+// cubic resampling always runs from a table, its coefficients don't depend on the pitch
+// ratios in half steps don't need one, the DSP calculates the coefficients of their two phases once per cycle
+static void ansnd_update_resample_table(ansnd_voice_t* voice, u32 voice_index) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 relative_frequency = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+	bool sinc_table = ansnd_resample_tables_enabled &&
+		(voice->resample_quality == ANSND_RESAMPLE_QUALITY_SINC) &&
+		!(voice->flags & VOICE_FLAG_GLIDING);
+	if ((!sinc_table && (voice->resample_quality != ANSND_RESAMPLE_QUALITY_CUBIC)) ||
+		((relative_frequency & 0x7FFF) == 0) ||
+		!ansnd_resample_tables) {
+		parameter_block->resample_table_mask = 0;
+		return;
+	}
+	
+	if ((parameter_block->resample_table_mask != 0) &&
+		(ansnd_resample_table_steps[voice_index] == parameter_block->filter_step) &&
+		(ansnd_resample_table_qualities[voice_index] == voice->resample_quality)) {
+		return;
+	}
+	
+	ansnd_build_resample_table(voice_index, voice->resample_quality);
+}
+
+// frees tables that were swapped out, once the DSP has finished a cycle without them
+static void ansnd_release_resample_tables() {
+	if (ansnd_retired_resample_tables &&
+		(ansnd_dsp_cycles != ansnd_retired_resample_cycle)) {
+		free(ansnd_retired_resample_tables);
+		ansnd_retired_resample_tables = NULL;
+	}
+}
+
+// must not be called from the interrupt, the tables of all voices are rebuilt in the new memory when they are next mixed
+static s32 ansnd_allocate_resample_tables(u16 phases) {
+	ansnd_release_resample_tables();
+	
+	u32 table_size = phases * RESAMPLE_TABLE_ROW_SIZE * sizeof(s16);
+	if (ansnd_resample_tables && (ansnd_resample_table_size == table_size)) {
+		return ANSND_ERROR_OK;
+	}
+	
+	// the DSP has not finished a cycle since the last swap, it may still be reading either block
+	if (ansnd_retired_resample_tables) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	
+	s16* tables = memalign(32, table_size * MAX_PARAMETER_BLOCKS);
+	if (!tables) {
+		return ANSND_ERROR_OUT_OF_MEMORY;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s16* old_tables = ansnd_resample_tables;
+	ansnd_resample_tables       = tables;
+	ansnd_resample_table_size   = table_size;
+	ansnd_resample_table_phases = phases;
+	memset(ansnd_resample_table_qualities, 0xFF, sizeof(ansnd_resample_table_qualities));
+	
+	ansnd_command_block.resample_table_size  = table_size;
+	ansnd_command_block.resample_table_shift = -__builtin_ctz(table_size / 2);
+	
+	ansnd_retired_resample_tables = old_tables;
+	ansnd_retired_resample_cycle  = ansnd_dsp_cycles;
+	
+	_CPU_ISR_Restore(level);
+	
+	// the cycle the DSP is in may still be reading the old tables, if it doesn't finish they are kept until it has
+	if (old_tables) {
+		for (u32 i = 0; (i < 100) && (ansnd_dsp_cycles == ansnd_retired_resample_cycle); ++i) {
+			usleep(1000);
+		}
+		ansnd_release_resample_tables();
+	}
+	
+	return ANSND_ERROR_OK;
+}
+
+static void ansnd_update_voice_pitch(ansnd_voice_t* voice, bool keep_history) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 relative_frequency = ansnd_calculate_relative_frequency(voice);
+	parameter_block->relative_frequency_high = HIGH(relative_frequency);
+	parameter_block->relative_frequency_low  = LOW(relative_frequency);
+	parameter_block->glide_cycles            = 0;
+	voice->flags                             &= ~VOICE_FLAG_GLIDING;
+	
+	ansnd_update_voice_filter(voice, relative_frequency, keep_history);
+}
+
+static void ansnd_start_voice_glide(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
+	u32 glide_cycles = (voice->setup->glide_time + microseconds_per_cycle - 1) / microseconds_per_cycle;
+	if (glide_cycles > 0xFFFF) {
+		glide_cycles = 0xFFFF;
+	}
+	
+	// glide from wherever the DSP currently is, which may be partway through another glide
+	u32 start_frequency  = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+	u32 target_frequency = ansnd_calculate_relative_frequency(voice);
+	if ((glide_cycles <= 1) || (start_frequency == target_frequency)) {
+		ansnd_update_voice_pitch(voice, true);
+		return;
+	}
+	
+	u32 glide_delta = 0;
+	if (voice->setup->glide_mode == ANSND_GLIDE_MODE_EXPONENTIAL) {
+		// per cycle factor - 1 as signed 1.31 fixed point, low half stored shifted right by 1 for the DSP
+		f32 factor = powf((f32)target_frequency / start_frequency, 1.f / glide_cycles) - 1.f;
+		if (factor > 0.9999f) {
+			factor = 0.9999f;
+		}
+		s32 fixed_factor = lrintf(factor * 2147483648.f);
+		glide_delta      = (fixed_factor & 0xFFFF0000) | (LOW(fixed_factor) >> 1);
+	} else {
+		glide_delta = ((s32)target_frequency - (s32)start_frequency) / (s32)glide_cycles;
+	}
+	
+	parameter_block->glide_mode        = voice->setup->glide_mode;
+	parameter_block->glide_delta_high  = HIGH(glide_delta);
+	parameter_block->glide_delta_low   = LOW(glide_delta);
+	parameter_block->glide_target_high = HIGH(target_frequency);
+	parameter_block->glide_target_low  = LOW(target_frequency);
+	parameter_block->glide_cycles      = glide_cycles;
+	
+	voice->flags |= VOICE_FLAG_GLIDING;
+}
+
 static void ansnd_update_voice_delay(ansnd_voice_t* voice) {
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
 	f32 dsp_frequency = 1.f;
-	u32 microseconds_per_cycle = 0;
 	switch (ansnd_output_samplerate) {
 	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
 		dsp_frequency = ANSND_DSP_FREQ_32KHZ;
-		microseconds_per_cycle = 7500;
 		break;
 	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
 		dsp_frequency = ANSND_DSP_FREQ_48KHZ;
-		microseconds_per_cycle = 5000;
 		break;
 #if defined(HW_DOL)
 	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
 		dsp_frequency = ANSND_DSP_FREQ_96KHZ;
-		microseconds_per_cycle = 2500;
 		break;
 #endif
 	default:
@@ -358,13 +1133,431 @@ static void ansnd_update_voice_delay(ansnd_voice_t* voice) {
 	}
 }
 
-static void ansnd_initialize_voice(ansnd_voice_t* voice) {
+static void ansnd_update_voice_volume(ansnd_voice_t* voice) {
 	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
-	memset(parameter_block, 0, PARAMETER_BLOCK_STRUCT_SIZE);
 	
-	ansnd_update_voice_pitch(voice);
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
 	
-	if (voice->delay != 0) {
+	s16 right_volume_target = lrintf(0x7FFF * voice->right_volume);
+	s16 left_volume_target  = lrintf(0x7FFF * voice->left_volume);
+	parameter_block->right_volume_target = right_volume_target;
+	parameter_block->left_volume_target  = left_volume_target;
+	
+	parameter_block->right_volume_low = 0;
+	parameter_block->left_volume_low  = 0;
+	
+	if ((right_volume_target == parameter_block->right_volume) &&
+		(left_volume_target == parameter_block->left_volume)) {
+		parameter_block->volume_ramp_cycles      = 0;
+		parameter_block->right_volume_delta_high = 0;
+		parameter_block->right_volume_delta_low  = 0;
+		parameter_block->left_volume_delta_high  = 0;
+		parameter_block->left_volume_delta_low   = 0;
+		return;
+	}
+	
+	// always ramp over at least 1 cycle to avoid zipper noise
+	u32 ramp_cycles = (voice->setup->volume_ramp_time + microseconds_per_cycle - 1) / microseconds_per_cycle;
+	if (ramp_cycles == 0) {
+		ramp_cycles = 1;
+	} else if (ramp_cycles > 0xFFFF) {
+		ramp_cycles = 0xFFFF;
+	}
+	
+	// per output sample deltas in 16.16 fixed point, truncated so the ramp never overshoots its target
+	s64 ramp_samples = ramp_cycles * ANSND_SAMPLES_PER_CYCLE;
+	s32 right_volume_delta = (((s64)(right_volume_target - parameter_block->right_volume)) << 16) / ramp_samples;
+	s32 left_volume_delta  = (((s64)(left_volume_target - parameter_block->left_volume)) << 16) / ramp_samples;
+	
+	parameter_block->volume_ramp_cycles      = ramp_cycles;
+	parameter_block->right_volume_delta_high = HIGH(right_volume_delta);
+	parameter_block->right_volume_delta_low  = LOW(right_volume_delta);
+	parameter_block->left_volume_delta_high  = HIGH(left_volume_delta);
+	parameter_block->left_volume_delta_low   = LOW(left_volume_delta);
+}
+
+static void ansnd_update_voice_envelope(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
+	// each stage takes at least 1 cycle so the DSP ramps between levels instead of jumping
+	u32 attack_cycles  = (voice->setup->envelope.attack_time + microseconds_per_cycle - 1) / microseconds_per_cycle;
+	u32 decay_cycles   = (voice->setup->envelope.decay_time + microseconds_per_cycle - 1) / microseconds_per_cycle;
+	u32 release_cycles = (voice->setup->envelope.release_time + microseconds_per_cycle - 1) / microseconds_per_cycle;
+	attack_cycles  = (attack_cycles == 0)  ? 1 : attack_cycles;
+	decay_cycles   = (decay_cycles == 0)   ? 1 : decay_cycles;
+	release_cycles = (release_cycles == 0) ? 1 : release_cycles;
+	
+	s32 sustain = lrintf(0x7FFF * voice->setup->envelope.sustain_level);
+	
+	// per cycle level deltas in 16.16 fixed point
+	u32 attack_delta  = 0x7FFF0000 / attack_cycles;
+	u32 decay_delta   = ((u32)(0x7FFF - sustain) << 16) / decay_cycles;
+	u32 release_delta = ((u32)((sustain == 0) ? 0x7FFF : sustain) << 16) / release_cycles;
+	
+	parameter_block->envelope_attack_high  = HIGH(attack_delta);
+	parameter_block->envelope_attack_low   = LOW(attack_delta);
+	parameter_block->envelope_decay_high   = HIGH(decay_delta);
+	parameter_block->envelope_decay_low    = LOW(decay_delta);
+	parameter_block->envelope_sustain      = sustain;
+	parameter_block->envelope_release_high = HIGH(release_delta);
+	parameter_block->envelope_release_low  = LOW(release_delta);
+}
+
+static void ansnd_update_voice_lfo(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
+	parameter_block->lfo_shape      = voice->lfo_shape;
+	parameter_block->lfo_phase_step = lrintf(voice->setup->lfo_rate * microseconds_per_cycle * (65536.f / 1000000.f));
+	
+	// the DSP offsets the relative frequency linearly, in 1/8192ths of the base frequency
+	// the modulated samplerate is kept within 4 times the output samplerate, so any valid depth fits
+	// and only the snapping of the relative frequency can round it past the limit, by a fraction of a percent
+	u32 relative_frequency = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+	f32 pitch_depth = (relative_frequency / 8.f) * (powf(2.f, voice->setup->lfo_pitch_depth / 12.f) - 1.f);
+	if (pitch_depth > 32767.f) {
+		pitch_depth = 32767.f;
+	}
+	parameter_block->lfo_pitch_depth  = lrintf(pitch_depth);
+	parameter_block->lfo_volume_depth = lrintf(0x7FFF * voice->setup->lfo_volume_depth);
+}
+
+static ansnd_biquad_coefficient_t ansnd_biquad_coefficient(f64 coefficient) {
+	f64 fixed_coefficient = round(coefficient * 1073741824.0);
+	if (fixed_coefficient > 2147483647.0) {
+		fixed_coefficient = 2147483647.0;
+	} else if (fixed_coefficient < -2147483648.0) {
+		fixed_coefficient = -2147483648.0;
+	}
+	
+	s32 value = (s32)fixed_coefficient;
+	ansnd_biquad_coefficient_t split_coefficient;
+	split_coefficient.high = value >> 16;
+	split_coefficient.low  = (value & 0xFFFF) >> 1;
+	return split_coefficient;
+}
+
+static void ansnd_update_voice_biquad(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	f32 dsp_frequency = 1.f;
+	switch (ansnd_output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		dsp_frequency = ANSND_DSP_FREQ_32KHZ;
+		break;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		dsp_frequency = ANSND_DSP_FREQ_48KHZ;
+		break;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		dsp_frequency = ANSND_DSP_FREQ_96KHZ;
+		break;
+#endif
+	default:
+		break;
+	}
+	
+	if (voice->biquad_type == ANSND_BIQUAD_TYPE_OFF) {
+		parameter_block->biquad_type = ANSND_BIQUAD_TYPE_OFF;
+		return;
+	}
+	
+	// RBJ audio eq cookbook filters, normalized by a0
+	// calculated in double precision, at low cutoffs the poles depend on 1 - cos(omega), which is lost in single precision
+	f64 omega = 2.0 * M_PI * ((f64)voice->setup->biquad_cutoff / dsp_frequency);
+	f64 cos_omega = cos(omega);
+	f64 alpha = sin(omega) / (2.0 * voice->setup->biquad_q);
+	f64 a0 = 1.0 + alpha;
+	
+	f64 b0 = 0.0;
+	f64 b1 = 0.0;
+	f64 b2 = 0.0;
+	switch (voice->biquad_type) {
+	case ANSND_BIQUAD_TYPE_LOW_PASS:
+		b0 = (1.0 - cos_omega) * 0.5;
+		b1 = 1.0 - cos_omega;
+		b2 = b0;
+		break;
+	case ANSND_BIQUAD_TYPE_HIGH_PASS:
+		b0 = (1.0 + cos_omega) * 0.5;
+		b1 = -(1.0 + cos_omega);
+		b2 = b0;
+		break;
+	case ANSND_BIQUAD_TYPE_BAND_PASS:
+		b0 = alpha;
+		b1 = 0.0;
+		b2 = -alpha;
+		break;
+	default:
+		break;
+	}
+	
+	ansnd_biquad_coefficients_t* const coefficients = &parameter_block->biquad_coefficients;
+	coefficients->b0 = ansnd_biquad_coefficient(b0 / a0);
+	coefficients->b1 = ansnd_biquad_coefficient(b1 / a0);
+	coefficients->b2 = ansnd_biquad_coefficient(b2 / a0);
+	// the DSP only accumulates, so the feedback coefficients are stored negated
+	coefficients->a1 = ansnd_biquad_coefficient((2.0 * cos_omega) / a0);
+	coefficients->a2 = ansnd_biquad_coefficient(-(1.0 - alpha) / a0);
+	
+	// stale state from a previous filter would pop when the filter is switched back on
+	if (parameter_block->biquad_type == ANSND_BIQUAD_TYPE_OFF) {
+		memset(&parameter_block->biquad_right, 0, sizeof(ansnd_biquad_state_t));
+		memset(&parameter_block->biquad_left, 0, sizeof(ansnd_biquad_state_t));
+	}
+	parameter_block->biquad_type = voice->biquad_type;
+}
+
+static void ansnd_update_voice_aux_sends(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	for (u32 i = 0; i < ANSND_MAX_AUX_BUSES; ++i) {
+		parameter_block->aux_send[i] = lrintf(0x7FFF * voice->setup->aux_send[i]);
+	}
+}
+
+static void ansnd_update_voice_meter(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	// the power is the sum of both channels squared, divided by 256
+	u32 power = (parameter_block->meter_power_high << 16) | parameter_block->meter_power_low;
+	
+	voice->meter_peak = parameter_block->meter_peak / 32767.f;
+	voice->meter_rms  = 0.f;
+	if (parameter_block->meter_samples != 0) {
+		voice->meter_rms = sqrtf((power * 256.f) / (parameter_block->meter_samples * 2)) / 32768.f;
+	}
+	
+	// voices the DSP skips read as silent on the next cycle
+	parameter_block->meter_peak       = 0;
+	parameter_block->meter_power_high = 0;
+	parameter_block->meter_power_low  = 0;
+	parameter_block->meter_samples    = 0;
+}
+
+// converts an accelerator address into samples from the start of the voice data
+static u32 ansnd_address_to_samples(ansnd_voice_t* voice, u32 address) {
+	u32 offset = address - voice->ram_buffer_start;
+	
+	if (voice->flags & VOICE_FLAG_ADPCM) {
+		// every frame of 16 nibbles starts with a 2 nibble header
+		u32 nibble = offset % 16;
+		return ((offset / 16) * 14) + ((nibble < 2) ? 0 : (nibble - 2));
+	}
+	if (voice->flags & VOICE_FLAG_STEREO) {
+		return offset / 2;
+	}
+	return offset;
+}
+
+static bool ansnd_voice_inaudible(ansnd_voice_t* voice) {
+	if (!ansnd_virtualization) {
+		return false;
+	}
+	
+	f32 volume = fmaxf(fabsf(voice->left_volume), fabsf(voice->right_volume));
+	volume *= ansnd_command_block.mix_table.groups[voice->group].volume / 32767.f;
+	return volume <= ansnd_virtualization_threshold;
+}
+
+// voices with DSP side state that changes over time keep running on the DSP
+static bool ansnd_voice_virtualizable(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	if ((voice->flags & (VOICE_FLAG_PAUSED | VOICE_FLAG_DELAY | VOICE_FLAG_STREAMING |
+		VOICE_FLAG_GLIDING | VOICE_FLAG_RELEASING | VOICE_FLAG_VOLUME_CHANGE)) ||
+		(voice->linked_voice)) {
+		return false;
+	}
+	
+	return (parameter_block->flags & VOICE_FLAG_RUNNING) &&
+		!(parameter_block->flags & VOICE_FLAG_FINISHED) &&
+		(parameter_block->volume_ramp_cycles == 0);
+}
+
+static void ansnd_virtualize_voice(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 address = (parameter_block->accelerator_current_high << 16) | parameter_block->accelerator_current_low;
+	voice->virtual_position = ((u64)ansnd_address_to_samples(voice, address)) << 16;
+	
+	// the DSP skips the voice until it is audible again
+	parameter_block->flags &= ~VOICE_FLAG_RUNNING;
+	voice->flags           |= VOICE_FLAG_VIRTUAL;
+}
+
+// moves the voice along as far as the DSP would have in one cycle
+static void ansnd_advance_virtual_voice(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 relative_frequency = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+	voice->virtual_position += (u64)relative_frequency * ANSND_SAMPLES_PER_CYCLE;
+	
+	u32 end         = (parameter_block->accelerator_end_high << 16) | parameter_block->accelerator_end_low;
+	u32 end_samples = ansnd_address_to_samples(voice, end);
+	u64 position    = voice->virtual_position >> 16;
+	if (position <= end_samples) {
+		return;
+	}
+	
+	if (parameter_block->flags & VOICE_FLAG_LOOPED) {
+		u32 loop_start = (parameter_block->looping.loop_start_high << 16) | parameter_block->looping.loop_start_low;
+		u32 loop_start_samples = ansnd_address_to_samples(voice, loop_start);
+		u32 loop_samples       = end_samples - loop_start_samples + 1;
+		
+		position = loop_start_samples + ((position - end_samples - 1) % loop_samples);
+		voice->virtual_position = (position << 16) | (voice->virtual_position & 0xFFFF);
+	} else {
+		// reported on the next cycle like a voice the DSP finished
+		parameter_block->flags |= VOICE_FLAG_FINISHED;
+		voice->flags           &= ~VOICE_FLAG_VIRTUAL;
+	}
+}
+
+static void ansnd_devirtualize_voice(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	u32 position = voice->virtual_position >> 16;
+	u32 address  = voice->ram_buffer_start;
+	
+	if (voice->flags & VOICE_FLAG_ADPCM) {
+		// resume on a frame header so the accelerator loads its predictor, the history starts from silence
+		address += (position / 14) * 16;
+		parameter_block->initial_predictor_scale  = 0;
+		parameter_block->initial_sample_history_1 = 0;
+		parameter_block->initial_sample_history_2 = 0;
+	} else {
+		address += (voice->flags & VOICE_FLAG_STEREO) ? (position * 2) : position;
+		memset(parameter_block->pcm.sample_buffer_2, 0, sizeof(parameter_block->pcm.sample_buffer_2));
+	}
+	memset(parameter_block->sample_buffer, 0, sizeof(parameter_block->sample_buffer));
+	
+	parameter_block->accelerator_current_high = HIGH(address);
+	parameter_block->accelerator_current_low  = LOW(address);
+	parameter_block->count_low                = 0;
+	
+	parameter_block->flags |= VOICE_FLAG_RUNNING;
+	voice->flags           &= ~VOICE_FLAG_VIRTUAL;
+}
+
+static void ansnd_update_voice_virtualization(ansnd_voice_t* voice) {
+	if (!(voice->flags & VOICE_FLAG_VIRTUAL)) {
+		if (ansnd_voice_virtualizable(voice) && ansnd_voice_inaudible(voice)) {
+			ansnd_virtualize_voice(voice);
+		}
+		return;
+	}
+	
+	// any change the DSP has to carry out brings the voice back as well
+	if ((voice->flags & (VOICE_FLAG_GLIDING | VOICE_FLAG_RELEASING | VOICE_FLAG_VOLUME_CHANGE)) ||
+		!ansnd_voice_inaudible(voice)) {
+		ansnd_devirtualize_voice(voice);
+		return;
+	}
+	
+	if (!(voice->flags & VOICE_FLAG_PAUSED) &&
+		!(ansnd_command_block.mix_table.groups[voice->group].flags & GROUP_FLAG_PAUSED)) {
+		ansnd_advance_virtual_voice(voice);
+	}
+}
+
+static void ansnd_update_voice_glide(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	
+	// keep the resampling filter matched to the frequency the DSP has reached
+	u32 relative_frequency = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+	ansnd_update_voice_filter(voice, relative_frequency, true);
+	
+	if (voice->lfo_shape != ANSND_LFO_SHAPE_OFF) {
+		ansnd_update_voice_lfo(voice);
+	}
+	
+	if (parameter_block->glide_cycles == 0) {
+		voice->flags &= ~VOICE_FLAG_GLIDING;
+	}
+}
+
+static void ansnd_release_voice(ansnd_voice_t* voice) {
+	ansnd_mark_voice_updated(voice);
+	
+	if ((voice->flags & VOICE_FLAG_ENVELOPE)    &&
+		(voice->flags & VOICE_FLAG_RUNNING)     &&
+		(voice->flags & VOICE_FLAG_INITIALIZED) &&
+		!(voice->flags & VOICE_FLAG_PAUSED)     &&
+		!(voice->flags & VOICE_FLAG_RELEASING)) {
+		// the DSP finishes the voice once the release reaches silence
+		voice->flags |= VOICE_FLAG_RELEASING;
+	} else {
+		voice->flags &= ~VOICE_FLAG_RUNNING;
+	}
+}
+
+// the parts of the parameter block that only depend on the configuration of the voice
+static void ansnd_build_parameter_block(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	memset(parameter_block, 0, PARAMETER_BLOCK_STRUCT_SIZE);
+	
+	ansnd_update_voice_pitch(voice, false);
+	
+	parameter_block->gain = 0x7FFF;
+	if (voice->flags & VOICE_FLAG_ENVELOPE) {
+		ansnd_update_voice_envelope(voice);
+		parameter_block->envelope_state = ENVELOPE_STATE_ATTACK;
+		parameter_block->gain           = 0;
+	}
+	
+	parameter_block->accelerator_format = voice->setup->accelerator_format;
+	parameter_block->accelerator_gain   = voice->setup->accelerator_gain;
+	
+	parameter_block->accelerator_start_high = HIGH(voice->ram_buffer_start);
+	parameter_block->accelerator_start_low  = LOW(voice->ram_buffer_start);
+	
+	parameter_block->accelerator_end_high = HIGH(voice->setup->ram_buffer_end);
+	parameter_block->accelerator_end_low  = LOW(voice->setup->ram_buffer_end);
+	
+	parameter_block->accelerator_current_high = HIGH(voice->setup->ram_buffer_first);
+	parameter_block->accelerator_current_low  = LOW(voice->setup->ram_buffer_first);
+	
+	parameter_block->initial_predictor_scale  = voice->setup->initial_predictor_scale;
+	parameter_block->initial_sample_history_1 = voice->setup->initial_sample_history_1;
+	parameter_block->initial_sample_history_2 = voice->setup->initial_sample_history_2;
+	
+	if (voice->flags & VOICE_FLAG_LOOPED) {
+		parameter_block->looping.loop_start_high = HIGH(voice->setup->looping.loop_start);
+		parameter_block->looping.loop_start_low  = LOW(voice->setup->looping.loop_start);
+		parameter_block->accelerator_end_high    = HIGH(voice->setup->looping.loop_end);
+		parameter_block->accelerator_end_low     = LOW(voice->setup->looping.loop_end);
+		
+		parameter_block->looping.loop_predictor_scale  = voice->setup->looping.loop_predictor_scale;
+		parameter_block->looping.loop_sample_history_1 = voice->setup->looping.loop_sample_history_1;
+		parameter_block->looping.loop_sample_history_2 = voice->setup->looping.loop_sample_history_2;
+	}
+	
+	if (voice->flags & VOICE_FLAG_ADPCM) {
+		for (u32 i = 0; i < 16; ++i) {
+			parameter_block->adpcm.decode_coefficients[i] = voice->setup->decode_coefficients[i];
+		}
+	}
+}
+
+static void ansnd_initialize_voice(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = voice->parameter_block;
+	voice->flags &= ~(VOICE_FLAG_VIRTUAL | VOICE_FLAG_STREAM_REQUEST);
+	
+	// a request still in the queue belongs to the previous run of the stream
+	voice->streaming.request_sequence++;
+	
+	// voices configured from a template start from the parameter block it built
+	if (voice->parameter_block_image) {
+		memcpy(parameter_block, voice->parameter_block_image, PARAMETER_BLOCK_STRUCT_SIZE);
+	} else {
+		ansnd_build_parameter_block(voice);
+	}
+	
+	if (voice->delay != 0) {
 		parameter_block->flags |= VOICE_FLAG_DELAY;
 		voice->flags           |= VOICE_FLAG_DELAY;
 		ansnd_update_voice_delay(voice);
@@ -373,6 +1566,29 @@ static void ansnd_initialize_voice(ansnd_voice_t* voice) {
 	parameter_block->left_volume  = lrintf(0x7FFF * voice->left_volume);
 	parameter_block->right_volume = lrintf(0x7FFF * voice->right_volume);
 	
+	parameter_block->left_volume_target  = parameter_block->left_volume;
+	parameter_block->right_volume_target = parameter_block->right_volume;
+	voice->flags &= ~VOICE_FLAG_VOLUME_CHANGE;
+	
+	if (voice->lfo_shape != ANSND_LFO_SHAPE_OFF) {
+		ansnd_update_voice_lfo(voice);
+	}
+	voice->flags &= ~VOICE_FLAG_LFO_CHANGE;
+	
+	if (voice->biquad_type != ANSND_BIQUAD_TYPE_OFF) {
+		ansnd_update_voice_biquad(voice);
+	}
+	voice->flags &= ~VOICE_FLAG_BIQUAD_CHANGE;
+	
+	ansnd_update_voice_aux_sends(voice);
+	voice->flags &= ~VOICE_FLAG_AUX_CHANGE;
+	
+	parameter_block->group = voice->group;
+	voice->flags &= ~VOICE_FLAG_GROUP_CHANGE;
+	
+	parameter_block->meter = voice->metering;
+	voice->flags &= ~VOICE_FLAG_METER_CHANGE;
+	
 	u16 mask = 
 		VOICE_FLAG_USED      | 
 		VOICE_FLAG_RUNNING   | 
@@ -385,51 +1601,205 @@ static void ansnd_initialize_voice(ansnd_voice_t* voice) {
 	
 	parameter_block->flags |= voice->flags & mask;
 	
-	parameter_block->accelerator_format = voice->accelerator_format;
-	parameter_block->accelerator_gain   = voice->accelerator_gain;
+	if (voice->flags & VOICE_FLAG_LOOPED) {
+		parameter_block->flags &= ~VOICE_FLAG_STREAMING;
+	}
 	
-	parameter_block->accelerator_start_high = HIGH(voice->ram_buffer_start);
-	parameter_block->accelerator_start_low  = LOW(voice->ram_buffer_start);
+	voice->flags |= VOICE_FLAG_INITIALIZED;
+}
+
+// stops the sound a stolen voice was playing, returns false while it is still fading out
+static bool ansnd_reclaim_voice(ansnd_voice_t* voice) {
+	ansnd_parameter_block_t* const parameter_block = &ansnd_parameter_blocks[voice - ansnd_voices];
+	
+	if ((voice->flags & VOICE_FLAG_FADING) &&
+		(parameter_block->flags & VOICE_FLAG_RUNNING) &&
+		!(parameter_block->flags & VOICE_FLAG_PAUSED)) {
+		voice->flags &= ~VOICE_FLAG_FADING;
+		
+		// ramp to silence over the next cycle, the slot is handed over on the one after
+		s32 right_volume_delta = -(((s32)parameter_block->right_volume) << 16) / ANSND_SAMPLES_PER_CYCLE;
+		s32 left_volume_delta  = -(((s32)parameter_block->left_volume) << 16) / ANSND_SAMPLES_PER_CYCLE;
+		
+		parameter_block->right_volume_target     = 0;
+		parameter_block->left_volume_target      = 0;
+		parameter_block->right_volume_low        = 0;
+		parameter_block->left_volume_low         = 0;
+		parameter_block->volume_ramp_cycles      = 1;
+		parameter_block->right_volume_delta_high = HIGH(right_volume_delta);
+		parameter_block->right_volume_delta_low  = LOW(right_volume_delta);
+		parameter_block->left_volume_delta_high  = HIGH(left_volume_delta);
+		parameter_block->left_volume_delta_low   = LOW(left_volume_delta);
+		return false;
+	}
+	
+	voice->flags &= ~(VOICE_FLAG_STOLEN | VOICE_FLAG_FADING);
+	memset(parameter_block, 0, PARAMETER_BLOCK_STRUCT_SIZE);
+	return true;
+}
+
+// how loud a voice is heard, used to pick a voice to steal
+static f32 ansnd_voice_loudness(ansnd_voice_t* voice) {
+	if (!(voice->flags & VOICE_FLAG_RUNNING) ||
+		(voice->flags & VOICE_FLAG_PAUSED)) {
+		return 0.f;
+	}
+	
+	f32 loudness = fmaxf(fabsf(voice->left_volume), fabsf(voice->right_volume));
+	loudness *= ansnd_command_block.mix_table.groups[voice->group].volume / 32767.f;
+	if (voice->metering) {
+		loudness *= voice->meter_rms;
+	}
+	return loudness;
+}
+
+// the configuration of a voice is replaced, what it was allocated and linked with stays
+static void ansnd_apply_voice_template(ansnd_voice_t* voice, const ansnd_voice_template_t* voice_template, ansnd_parameter_block_t* parameter_block) {
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	ansnd_voice_allocation_t allocation = voice->allocation;
+	u32 steal_flags = voice->flags & (VOICE_FLAG_STOLEN | VOICE_FLAG_FADING);
+	ansnd_voice_setup_t* setup = voice->setup;
+	u32 request_sequence = voice->streaming.request_sequence + 1;
+	memcpy(voice, &voice_template->voice, sizeof(ansnd_voice_t));
+	memcpy(setup, &voice_template->setup, sizeof(ansnd_voice_setup_t));
+	
+	voice->setup        = setup;
+	voice->allocation   = allocation;
+	voice->flags        |= steal_flags;
+	voice->linked_voice = linked_voice;
+	
+	voice->streaming.request_sequence = request_sequence;
+	
+	voice->parameter_block       = parameter_block;
+	voice->parameter_block_image = &voice_template->parameter_block;
+}
+
+static s32 ansnd_find_voice_template() {
+	for (u32 i = 0; i < ANSND_MAX_VOICE_TEMPLATES; ++i) {
+		if (!ansnd_voice_templates[i].used) {
+			return i;
+		}
+	}
+	return ANSND_ERROR_ALL_TEMPLATES_USED;
+}
+
+// picks the lowest priority voice at or below the given priority, then the quietest, then the oldest
+static s32 ansnd_find_voice_to_steal(u8 priority, s32 voice_class) {
+	s32 voice_id = -1;
+	f32 voice_loudness = 0.f;
+	
+	for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
+		ansnd_voice_t* voice = &ansnd_voices[i];
+		
+		// linked voices only make sense together, and erased voices are about to be freed anyway
+		if (!(voice->flags & VOICE_FLAG_USED) ||
+			(voice->flags & VOICE_FLAG_ERASED) ||
+			(voice->linked_voice) ||
+			(voice->allocation.priority > priority)) {
+			continue;
+		}
+		if ((voice_class >= 0) &&
+			(voice->allocation.voice_class != voice_class)) {
+			continue;
+		}
+		
+		f32 loudness = ansnd_voice_loudness(voice);
+		if (voice_id >= 0) {
+			ansnd_voice_t* victim = &ansnd_voices[voice_id];
+			
+			if (voice->allocation.priority != victim->allocation.priority) {
+				if (voice->allocation.priority > victim->allocation.priority) {
+					continue;
+				}
+			} else if (loudness != voice_loudness) {
+				if (loudness > voice_loudness) {
+					continue;
+				}
+			} else if ((s32)(voice->allocation.order - victim->allocation.order) > 0) {
+				continue;
+			}
+		}
+		
+		voice_id       = i;
+		voice_loudness = loudness;
+	}
 	
-	parameter_block->accelerator_end_high = HIGH(voice->ram_buffer_end);
-	parameter_block->accelerator_end_low  = LOW(voice->ram_buffer_end);
+	return voice_id;
+}
+
+static void ansnd_steal_voice(ansnd_voice_t* voice, bool fade) {
+	// queued in the polled and thread modes, so user code doesn't run here with interrupts disabled
+	ansnd_notify_voice_state(voice, ANSND_VOICE_STATE_STOLEN);
 	
-	parameter_block->accelerator_current_high = HIGH(voice->ram_buffer_first);
-	parameter_block->accelerator_current_low  = LOW(voice->ram_buffer_first);
+	// the DSP keeps the old sound until the next cycle, where it is faded out or cut
+	ansnd_voice_class_counts[voice->allocation.voice_class]--;
 	
-	parameter_block->initial_predictor_scale  = voice->initial_predictor_scale;
-	parameter_block->initial_sample_history_1 = voice->initial_sample_history_1;
-	parameter_block->initial_sample_history_2 = voice->initial_sample_history_2;
+	u32 steal_flags = voice->flags & (VOICE_FLAG_STOLEN | VOICE_FLAG_FADING);
+	if (fade && (voice->flags & VOICE_FLAG_RUNNING)) {
+		steal_flags |= VOICE_FLAG_FADING;
+	}
+	ansnd_clear_voice(voice);
 	
-	if (voice->flags & VOICE_FLAG_LOOPED) {
-		parameter_block->flags                   &= ~VOICE_FLAG_STREAMING;
-		parameter_block->looping.loop_start_high = HIGH(voice->looping.loop_start);
-		parameter_block->looping.loop_start_low  = LOW(voice->looping.loop_start);
-		parameter_block->accelerator_end_high    = HIGH(voice->looping.loop_end);
-		parameter_block->accelerator_end_low     = LOW(voice->looping.loop_end);
-		
-		parameter_block->looping.loop_predictor_scale  = voice->looping.loop_predictor_scale;
-		parameter_block->looping.loop_sample_history_1 = voice->looping.loop_sample_history_1;
-		parameter_block->looping.loop_sample_history_2 = voice->looping.loop_sample_history_2;
+	voice->flags = VOICE_FLAG_USED | VOICE_FLAG_STOLEN | steal_flags;
+	ansnd_mark_voice_updated(voice);
+}
+
+static s32 ansnd_allocate_voice_slot(u8 priority, u8 voice_class, bool steal, bool fade) {
+	// a full class only makes room by replacing one of its own voices
+	bool class_full = ansnd_voice_class_counts[voice_class] >= ansnd_voice_class_limits[voice_class];
+	
+	s32 voice_id = -1;
+	if (!class_full && (ansnd_free_voice_count > 0)) {
+		voice_id = ansnd_free_voices[--ansnd_free_voice_count];
 	}
 	
-	if (voice->flags & VOICE_FLAG_ADPCM) {
-		for (u32 i = 0; i < 16; ++i) {
-			parameter_block->adpcm.decode_coefficients[i] = voice->decode_coefficients[i];
+	if ((voice_id < 0) && steal) {
+		voice_id = ansnd_find_voice_to_steal(priority, class_full ? voice_class : -1);
+		if (voice_id >= 0) {
+			ansnd_steal_voice(&ansnd_voices[voice_id], fade);
 		}
 	}
 	
-	voice->flags |= VOICE_FLAG_INITIALIZED;
+	if (voice_id < 0) {
+		return class_full ? ANSND_ERROR_VOICE_CLASS_FULL : ANSND_ERROR_ALL_VOICES_USED;
+	}
+	
+	ansnd_voice_t* voice = &ansnd_voices[voice_id];
+	if (!(voice->flags & VOICE_FLAG_STOLEN)) {
+		ansnd_clear_voice(voice);
+		voice->flags = VOICE_FLAG_USED;
+	}
+	
+	voice->allocation.priority    = priority;
+	voice->allocation.voice_class = voice_class;
+	voice->allocation.order       = ansnd_allocation_count++;
+	ansnd_voice_class_counts[voice_class]++;
+	
+	// generation 0 is skipped so a handle never equals a plain voice index
+	u16 generation = (ansnd_voice_generations[voice_id] + 1) & VOICE_GENERATION_MASK;
+	if (generation == 0) {
+		generation = 1;
+	}
+	ansnd_voice_generations[voice_id] = generation;
+	
+	return VOICE_HANDLE(voice_id, generation);
 }
 
 static void ansnd_sync_voice(ansnd_voice_t* voice) {
 	if (voice->flags & VOICE_FLAG_ERASED) {
-		if (voice->voice_callback) {
-			voice->voice_callback(voice->user_pointer, ANSND_VOICE_STATE_ERASED);
-		}
+		ansnd_notify_voice_state(voice, ANSND_VOICE_STATE_ERASED);
 		ansnd_erase_voice(voice);
 		return;
 	}
+	if (voice->flags & VOICE_FLAG_STOLEN) {
+		if (!ansnd_reclaim_voice(voice)) {
+			return;
+		}
+		if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+			voice->flags &= ~VOICE_FLAG_UPDATED;
+			return;
+		}
+	}
 	s32 voice_state = ANSND_VOICE_STATE_ERROR;
 	
 	// voice states in descending order of priority
@@ -450,20 +1820,61 @@ static void ansnd_sync_voice(ansnd_voice_t* voice) {
 	}
 	
 	if (voice->flags & VOICE_FLAG_PITCH_CHANGE) {
-		memset(parameter_block->sample_buffer, 0, 16 * 2);
-		if (!(parameter_block->flags & VOICE_FLAG_ADPCM)) {
-			memset(parameter_block->pcm.sample_buffer_2, 0, 16 * 2);
+		if (voice->setup->glide_time != 0) {
+			ansnd_start_voice_glide(voice);
+		} else {
+			ansnd_update_voice_pitch(voice, true);
 		}
-		ansnd_update_voice_pitch(voice);
 		voice->flags &= ~VOICE_FLAG_PITCH_CHANGE;
+		
+		// the lfo pitch depth is relative to the new frequency
+		if (voice->lfo_shape != ANSND_LFO_SHAPE_OFF) {
+			voice->flags |= VOICE_FLAG_LFO_CHANGE;
+		}
+	}
+	
+	if (voice->flags & VOICE_FLAG_LFO_CHANGE) {
+		ansnd_update_voice_lfo(voice);
+		voice->flags &= ~VOICE_FLAG_LFO_CHANGE;
+	}
+	
+	if (voice->flags & VOICE_FLAG_BIQUAD_CHANGE) {
+		ansnd_update_voice_biquad(voice);
+		voice->flags &= ~VOICE_FLAG_BIQUAD_CHANGE;
+	}
+	
+	if (voice->flags & VOICE_FLAG_RESAMPLE_CHANGE) {
+		u32 relative_frequency = (parameter_block->relative_frequency_high << 16) | parameter_block->relative_frequency_low;
+		ansnd_update_voice_filter(voice, relative_frequency, true);
+		voice->flags &= ~VOICE_FLAG_RESAMPLE_CHANGE;
+	}
+	
+	if (voice->flags & VOICE_FLAG_AUX_CHANGE) {
+		ansnd_update_voice_aux_sends(voice);
+		voice->flags &= ~VOICE_FLAG_AUX_CHANGE;
+	}
+	
+	if (voice->flags & VOICE_FLAG_GROUP_CHANGE) {
+		parameter_block->group = voice->group;
+		voice->flags &= ~VOICE_FLAG_GROUP_CHANGE;
+	}
+	
+	if (voice->flags & VOICE_FLAG_METER_CHANGE) {
+		parameter_block->meter = voice->metering;
+		voice->flags &= ~VOICE_FLAG_METER_CHANGE;
 	}
 	
 	if (parameter_block->flags & VOICE_FLAG_FINISHED) {
 		parameter_block->flags &= ~VOICE_FLAG_FINISHED;
-		voice->flags           &= ~VOICE_FLAG_RUNNING;
+		voice->flags           &= ~(VOICE_FLAG_RUNNING | VOICE_FLAG_RELEASING);
 		voice_state            = ANSND_VOICE_STATE_FINISHED;
 	}
 	
+	if ((voice->flags & VOICE_FLAG_RELEASING) &&
+		(parameter_block->envelope_state != ENVELOPE_STATE_OFF)) {
+		parameter_block->envelope_state = ENVELOPE_STATE_RELEASE;
+	}
+	
 	u16 flags_diff = voice->flags ^ parameter_block->flags;
 	if (flags_diff & VOICE_FLAG_RUNNING) {
 		parameter_block->flags &= ~VOICE_FLAG_RUNNING;
@@ -474,8 +1885,8 @@ static void ansnd_sync_voice(ansnd_voice_t* voice) {
 	}
 	if (flags_diff & VOICE_FLAG_LOOPED) {
 		parameter_block->flags &= ~VOICE_FLAG_LOOPED;
-		parameter_block->accelerator_end_high = HIGH(voice->ram_buffer_end);
-		parameter_block->accelerator_end_low  = LOW(voice->ram_buffer_end);
+		parameter_block->accelerator_end_high = HIGH(voice->setup->ram_buffer_end);
+		parameter_block->accelerator_end_low  = LOW(voice->setup->ram_buffer_end);
 		
 		if (voice->flags & VOICE_FLAG_STREAMING) {
 			parameter_block->flags |= VOICE_FLAG_STREAMING;
@@ -483,13 +1894,19 @@ static void ansnd_sync_voice(ansnd_voice_t* voice) {
 		}
 	}
 	
-	parameter_block->left_volume  = lrintf(0x7FFF * voice->left_volume);
-	parameter_block->right_volume = lrintf(0x7FFF * voice->right_volume);
+	if (voice->flags & VOICE_FLAG_VOLUME_CHANGE) {
+		ansnd_update_voice_volume(voice);
+		voice->flags &= ~VOICE_FLAG_VOLUME_CHANGE;
+	}
 	
 	voice->flags &= ~VOICE_FLAG_UPDATED;
 	
-	if (voice->voice_callback) {
-		voice->voice_callback(voice->user_pointer, voice_state);
+	ansnd_notify_voice_state(voice, voice_state);
+	
+	// one-shots give their voice back as soon as they stop
+	if ((voice->flags & VOICE_FLAG_ONE_SHOT) &&
+		!(voice->flags & VOICE_FLAG_RUNNING)) {
+		ansnd_erase_voice(voice);
 	}
 }
 
@@ -514,102 +1931,354 @@ static void ansnd_write_stream_buffers(ansnd_voice_t* voice) {
 	voice->streaming.next_buffer_first = 0;
 }
 
+static void ansnd_store_adpcm_stream_buffer(ansnd_voice_t* voice, const ansnd_adpcm_data_buffer_t* data_buffer) {
+	if ((data_buffer->data_ptr == 0) ||
+		(data_buffer->sample_count == 0)) {
+		return;
+	}
+#if defined(HW_DOL)
+	if ((data_buffer->data_ptr < AR_GetBaseAddress()) ||
+		(data_buffer->data_ptr >= AR_GetSize())) {
+		return;
+	}
+#elif defined(HW_RVL)
+	if (data_buffer->data_ptr & SYS_BASE_CACHED) {
+		return;
+	}
+#endif
+	
+	voice->streaming.next_buffer_start = data_buffer->data_ptr << 1;
+	voice->streaming.next_buffer_end   = voice->streaming.next_buffer_start + SAMPLES_TO_NIBBLES(data_buffer->sample_count);
+	voice->streaming.next_buffer_first = voice->streaming.next_buffer_start + SAMPLES_TO_NIBBLES(0);
+	
+	voice->streaming.next_buffer_predictor_scale  = data_buffer->predictor_scale;
+	voice->streaming.next_buffer_sample_history_1 = data_buffer->sample_history_1;
+	voice->streaming.next_buffer_sample_history_2 = data_buffer->sample_history_2;
+}
+
+static void ansnd_store_pcm_stream_buffer(ansnd_voice_t* voice, const ansnd_pcm_data_buffer_t* data_buffer) {
+	if ((data_buffer->frame_data_ptr == 0) ||
+		(data_buffer->frame_count == 0)) {
+		return;
+	}
+#if defined(HW_DOL)
+	if ((data_buffer->frame_data_ptr < AR_GetBaseAddress()) ||
+		(data_buffer->frame_data_ptr >= AR_GetSize())) {
+		return;
+	}
+#elif defined(HW_RVL)
+	if (data_buffer->frame_data_ptr & SYS_BASE_CACHED) {
+		return;
+	}
+#endif
+	
+	u32 channels   = 1;
+	if (voice->flags & VOICE_FLAG_STEREO) {
+		channels   = 2;
+	}
+	
+	u32 memory_shift = 0;
+	if (voice->setup->accelerator_gain == DSP_ACCL_GAIN_16BIT) {
+		memory_shift = 1;
+	}
+	
+	voice->streaming.next_buffer_start = data_buffer->frame_data_ptr >> memory_shift;
+	// offset the end address so that the DSP accelerator overflow interrupt is generated at the right time
+	voice->streaming.next_buffer_end   = voice->streaming.next_buffer_start + data_buffer->frame_count * channels - 1;
+	voice->streaming.next_buffer_first = voice->streaming.next_buffer_start;
+}
+
 static void ansnd_fill_stream_buffers(ansnd_voice_t* voice) {
 	if (voice->flags & VOICE_FLAG_ADPCM) {
 		ansnd_adpcm_data_buffer_t data_buffer;
 		memset(&data_buffer, 0, sizeof(ansnd_adpcm_data_buffer_t));
 		
 		voice->stream_callback.adpcm_callback(voice->user_pointer, &data_buffer);
-		
-		if ((data_buffer.data_ptr == 0) ||
-			(data_buffer.sample_count == 0)) {
-			return;
-		}
-	#if defined(HW_DOL)
-		if ((data_buffer.data_ptr < AR_GetBaseAddress()) ||
-			(data_buffer.data_ptr >= AR_GetSize())) {
-			return;
-		}
-	#elif defined(HW_RVL)
-		if (data_buffer.data_ptr & SYS_BASE_CACHED) {
-			return;
-		}
-	#endif
-		
-		voice->streaming.next_buffer_start = data_buffer.data_ptr << 1;
-		voice->streaming.next_buffer_end   = voice->streaming.next_buffer_start + SAMPLES_TO_NIBBLES(data_buffer.sample_count);
-		voice->streaming.next_buffer_first = voice->streaming.next_buffer_start + SAMPLES_TO_NIBBLES(0);
-		
-		voice->streaming.next_buffer_predictor_scale  = data_buffer.predictor_scale;
-		voice->streaming.next_buffer_sample_history_1 = data_buffer.sample_history_1;
-		voice->streaming.next_buffer_sample_history_2 = data_buffer.sample_history_2;
+		ansnd_store_adpcm_stream_buffer(voice, &data_buffer);
 	} else {
 		ansnd_pcm_data_buffer_t data_buffer;
 		memset(&data_buffer, 0, sizeof(ansnd_pcm_data_buffer_t));
 		
 		voice->stream_callback.pcm_callback(voice->user_pointer, &data_buffer);
+		ansnd_store_pcm_stream_buffer(voice, &data_buffer);
+	}
+}
+
+static void ansnd_request_stream_buffers(ansnd_voice_t* voice) {
+	u32 voice_index = voice - ansnd_voices;
+	
+	ansnd_callback_event_t event;
+	event.type             = CALLBACK_EVENT_STREAM_DATA;
+	event.voice_id         = VOICE_HANDLE(voice_index, ansnd_voice_generations[voice_index]);
+	event.voice_state      = ANSND_VOICE_STATE_RUNNING;
+	event.adpcm            = voice->flags & VOICE_FLAG_ADPCM;
+	event.request_sequence = ++voice->streaming.request_sequence;
+	event.voice_callback   = NULL;
+	event.stream_callback  = voice->stream_callback;
+	event.user_pointer     = voice->user_pointer;
+	
+	if (ansnd_push_callback_event(&event)) {
+		voice->flags |= VOICE_FLAG_STREAM_REQUEST;
+	} else {
+		ansnd_fill_stream_buffers(voice);
+	}
+}
+
+static void ansnd_update_stream_buffers(ansnd_voice_t* voice) {
+	if (voice->streaming.next_buffer_start == 0) {
+		if (ansnd_callback_mode == ANSND_CALLBACK_MODE_IMMEDIATE) {
+			ansnd_fill_stream_buffers(voice);
+		} else if (!(voice->flags & VOICE_FLAG_STREAM_REQUEST)) {
+			ansnd_request_stream_buffers(voice);
+		}
+	}
+	
+	if ((voice->parameter_block->streaming.next_buffer_start_high == 0)	&&
+		(voice->parameter_block->streaming.next_buffer_start_low == 0)) {
+		ansnd_write_stream_buffers(voice);
+	}
+}
+
+// look-ahead limiter on the final mix, runs in bounded time per buffer
+static void ansnd_apply_limiter(s16* buffer, u32 stereo_samples) {
+	ansnd_limiter_t* const limiter = &ansnd_limiter;
+	
+	// recompute the running sum once per buffer so rounding errors cannot build up
+	limiter->smoothing_sum = 0.f;
+	for (u32 i = 0; i < LIMITER_LOOKAHEAD; ++i) {
+		limiter->smoothing_sum += limiter->smoothing_window[i];
+	}
+	
+	f32 minimum_smoothed_gain = 1.f;
+	for (u32 i = 0; i < stereo_samples; ++i) {
+		u32 position = limiter->position;
+		u32 slot     = limiter->slot;
 		
-		if ((data_buffer.frame_data_ptr == 0) ||
-			(data_buffer.frame_count == 0)) {
-			return;
+		f32 right = buffer[(i * 2) + 0] * limiter->input_gain;
+		f32 left  = buffer[(i * 2) + 1] * limiter->input_gain;
+		f32 peak  = fmaxf(fabsf(right), fabsf(left));
+		
+		f32 required_gain = 1.f;
+		if (peak > limiter->threshold) {
+			required_gain = limiter->threshold / peak;
 		}
-	#if defined(HW_DOL)
-		if ((data_buffer.frame_data_ptr < AR_GetBaseAddress()) ||
-			(data_buffer.frame_data_ptr >= AR_GetSize())) {
-			return;
+		
+		// hold the lowest gain required anywhere in the look-ahead window
+		if ((limiter->minimum_count > 0) &&
+			((position - limiter->minimum_positions[limiter->minimum_head]) >= LIMITER_LOOKAHEAD)) {
+			limiter->minimum_head = (limiter->minimum_head + 1) % LIMITER_LOOKAHEAD;
+			limiter->minimum_count--;
 		}
-	#elif defined(HW_RVL)
-		if (data_buffer.frame_data_ptr & SYS_BASE_CACHED) {
-			return;
+		while ((limiter->minimum_count > 0) &&
+			(limiter->minimum_gains[(limiter->minimum_head + limiter->minimum_count - 1) % LIMITER_LOOKAHEAD] >= required_gain)) {
+			limiter->minimum_count--;
 		}
-	#endif
+		u32 tail = (limiter->minimum_head + limiter->minimum_count) % LIMITER_LOOKAHEAD;
+		limiter->minimum_gains[tail]     = required_gain;
+		limiter->minimum_positions[tail] = position;
+		limiter->minimum_count++;
+		f32 held_gain = limiter->minimum_gains[limiter->minimum_head];
 		
-		u32 channels   = 1;
-		if (voice->flags & VOICE_FLAG_STEREO) {
-			channels   = 2;
+		if (held_gain < limiter->release_gain) {
+			limiter->release_gain = held_gain;
+		} else {
+			limiter->release_gain = held_gain - ((held_gain - limiter->release_gain) * limiter->release_coefficient);
 		}
 		
-		u32 memory_shift = 0;
-		if (voice->accelerator_gain == DSP_ACCL_GAIN_16BIT) {
-			memory_shift = 1;
+		// averaging over the window turns the hold into a ramp that reaches the held gain right as the peak leaves the delay line
+		limiter->smoothing_sum          += limiter->release_gain - limiter->smoothing_window[slot];
+		limiter->smoothing_window[slot] = limiter->release_gain;
+		f32 smoothed_gain = limiter->smoothing_sum * (1.f / LIMITER_LOOKAHEAD);
+		if (smoothed_gain < minimum_smoothed_gain) {
+			minimum_smoothed_gain = smoothed_gain;
 		}
 		
-		voice->streaming.next_buffer_start = data_buffer.frame_data_ptr >> memory_shift;
-		// offset the end address so that the DSP accelerator overflow interrupt is generated at the right time
-		voice->streaming.next_buffer_end   = voice->streaming.next_buffer_start + data_buffer.frame_count * channels - 1;
-		voice->streaming.next_buffer_first = voice->streaming.next_buffer_start;
+		// the oldest sample in the delay line is exactly LIMITER_LOOKAHEAD - 1 samples behind the newest
+		u32 delayed_slot = (slot + 1) % LIMITER_LOOKAHEAD;
+		limiter->delay_line[slot][0] = buffer[(i * 2) + 0];
+		limiter->delay_line[slot][1] = buffer[(i * 2) + 1];
+		
+		f32 gain = limiter->input_gain * smoothed_gain;
+		s32 limited_right = lrintf(limiter->delay_line[delayed_slot][0] * gain);
+		s32 limited_left  = lrintf(limiter->delay_line[delayed_slot][1] * gain);
+		buffer[(i * 2) + 0] = (limited_right > 32767) ? 32767 : ((limited_right < -32768) ? -32768 : limited_right);
+		buffer[(i * 2) + 1] = (limited_left  > 32767) ? 32767 : ((limited_left  < -32768) ? -32768 : limited_left);
+		
+		limiter->position++;
+		limiter->slot = delayed_slot;
+	}
+	
+	limiter->gain_reduction = 0.f;
+	if (minimum_smoothed_gain < 1.f) {
+		limiter->gain_reduction = -20.f * log10f(minimum_smoothed_gain);
 	}
 }
 
-static void ansnd_update_stream_buffers(ansnd_voice_t* voice) {
-	if (voice->streaming.next_buffer_start == 0) {
-		ansnd_fill_stream_buffers(voice);
+static void ansnd_update_voice(ansnd_voice_t* voice) {
+	if ((voice->flags & VOICE_FLAG_UPDATED) ||
+		((voice->parameter_block) && (voice->parameter_block->flags & VOICE_FLAG_FINISHED))) {
+		ansnd_sync_voice(voice);
 	}
 	
-	if ((voice->parameter_block->streaming.next_buffer_start_high == 0)	&&
-		(voice->parameter_block->streaming.next_buffer_start_low == 0)) {
-		ansnd_write_stream_buffers(voice);
+	// the previous sound of a stolen voice is still fading out
+	if (voice->flags & VOICE_FLAG_STOLEN) {
+		return;
+	}
+	
+	if (voice->metering) {
+		ansnd_update_voice_meter(voice);
+	}
+	
+	if (voice->flags & VOICE_FLAG_RUNNING) {
+		ansnd_active_voices++;
+	} else {
+		return;
+	}
+	
+	ansnd_update_voice_virtualization(voice);
+	if (voice->flags & VOICE_FLAG_VIRTUAL) {
+		ansnd_virtual_voices++;
+		return;
+	}
+	
+	if ((voice->flags & VOICE_FLAG_STREAMING) &&
+		!(voice->flags & VOICE_FLAG_LOOPED)) {
+		ansnd_update_stream_buffers(voice);
+	}
+	
+	if (voice->flags & VOICE_FLAG_DELAY) {
+		ansnd_update_voice_delay(voice);
+	}
+	
+	if (voice->flags & VOICE_FLAG_GLIDING) {
+		ansnd_update_voice_glide(voice);
 	}
 }
 
-static void ansnd_dsp_initialized_callback(dsptask_t* task) {
-	// send main memory locations
-	DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_MM_LOCATION);
-	while(DSP_CheckMailTo());
+static void ansnd_dispatch_stream_event(const ansnd_callback_event_t* event) {
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(event->voice_id)];
+	u32 level;
+	
+	// the callback runs outside of the interrupt, the buffer is only taken if the stream still wants it
+	// and the voice has not been restarted since, which the handle alone does not show
+	if (event->adpcm) {
+		ansnd_adpcm_data_buffer_t data_buffer;
+		memset(&data_buffer, 0, sizeof(ansnd_adpcm_data_buffer_t));
+		
+		event->stream_callback.adpcm_callback(event->user_pointer, &data_buffer);
+		
+		_CPU_ISR_Disable(level);
+		if (ansnd_voice_handle_valid(event->voice_id) &&
+			(voice->flags & VOICE_FLAG_STREAM_REQUEST) &&
+			(voice->streaming.request_sequence == event->request_sequence)) {
+			voice->flags &= ~VOICE_FLAG_STREAM_REQUEST;
+			ansnd_store_adpcm_stream_buffer(voice, &data_buffer);
+		}
+		_CPU_ISR_Restore(level);
+	} else {
+		ansnd_pcm_data_buffer_t data_buffer;
+		memset(&data_buffer, 0, sizeof(ansnd_pcm_data_buffer_t));
+		
+		event->stream_callback.pcm_callback(event->user_pointer, &data_buffer);
+		
+		_CPU_ISR_Disable(level);
+		if (ansnd_voice_handle_valid(event->voice_id) &&
+			(voice->flags & VOICE_FLAG_STREAM_REQUEST) &&
+			(voice->streaming.request_sequence == event->request_sequence)) {
+			voice->flags &= ~VOICE_FLAG_STREAM_REQUEST;
+			ansnd_store_pcm_stream_buffer(voice, &data_buffer);
+		}
+		_CPU_ISR_Restore(level);
+	}
+}
+
+// must only ever be called from one thread at a time
+static void ansnd_dispatch_callback_events() {
+	while (ansnd_callback_event_tail != ansnd_callback_event_head) {
+		u32 tail = ansnd_callback_event_tail;
+		
+		__sync_synchronize();
+		ansnd_callback_event_t event = ansnd_callback_events[tail % CALLBACK_EVENT_QUEUE_SIZE];
+		
+		// the slot can be reused as soon as the event is copied out
+		__sync_synchronize();
+		ansnd_callback_event_tail = tail + 1;
+		
+		switch (event.type) {
+		case CALLBACK_EVENT_VOICE_STATE:
+			event.voice_callback(event.user_pointer, event.voice_state);
+			break;
+		case CALLBACK_EVENT_STREAM_DATA:
+			ansnd_dispatch_stream_event(&event);
+			break;
+		}
+	}
+}
+
+static void* ansnd_callback_thread_main(void* arguments) {
+	u32 level;
+	
+	while (true) {
+		_CPU_ISR_Disable(level);
+		while ((ansnd_callback_event_tail == ansnd_callback_event_head) &&
+			!ansnd_callback_thread_quit) {
+			LWP_ThreadSleep(ansnd_callback_queue);
+		}
+		_CPU_ISR_Restore(level);
+		
+		if (ansnd_callback_thread_quit) {
+			break;
+		}
+		
+		ansnd_dispatch_callback_events();
+	}
 	
-	ansnd_parameter_block_t* parameter_block_base = (ansnd_parameter_block_t*)ansnd_dsp_dram_image;
+	return NULL;
+}
+
+static bool ansnd_start_callback_thread(u8 thread_priority) {
+	ansnd_callback_thread_quit = false;
 	
-	DSP_SendMailTo(MEM_VIRTUAL_TO_PHYSICAL(parameter_block_base));
-	while(DSP_CheckMailTo());
+	if (LWP_InitQueue(&ansnd_callback_queue) < 0) {
+		ansnd_callback_queue = LWP_TQUEUE_NULL;
+		return false;
+	}
+	if (LWP_CreateThread(&ansnd_callback_thread, ansnd_callback_thread_main, NULL, NULL, CALLBACK_THREAD_STACK_SIZE, thread_priority) < 0) {
+		ansnd_callback_thread = LWP_THREAD_NULL;
+		LWP_CloseQueue(ansnd_callback_queue);
+		ansnd_callback_queue = LWP_TQUEUE_NULL;
+		return false;
+	}
 	
-	DSP_SendMailTo(MEM_VIRTUAL_TO_PHYSICAL(ansnd_audio_buffer_out[0]));
-	while(DSP_CheckMailTo());
+	return true;
+}
+
+static void ansnd_stop_callback_thread() {
+	if (ansnd_callback_thread == LWP_THREAD_NULL) {
+		return;
+	}
 	
-	DSP_SendMailTo(MEM_VIRTUAL_TO_PHYSICAL(ansnd_audio_buffer_out[1]));
-	while(DSP_CheckMailTo());
+	ansnd_callback_thread_quit = true;
+	LWP_ThreadSignal(ansnd_callback_queue);
+	LWP_JoinThread(ansnd_callback_thread, NULL);
+	LWP_CloseQueue(ansnd_callback_queue);
 	
-	DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_RESTART);
-	while(DSP_CheckMailTo());
+	ansnd_callback_thread = LWP_THREAD_NULL;
+	ansnd_callback_queue  = LWP_TQUEUE_NULL;
+}
+
+// mails are sent while the DSP waits for its next command, so nothing waits for them to be read,
+// a mail that does get lost leaves the cycle stalled and the audio DMA callback restarts it
+static void ansnd_dsp_initialized_callback(dsptask_t* task) {
+	// the DSP takes the main memory locations from the first command block and starts the first cycle right after
+	ansnd_command_block.version          = COMMAND_BLOCK_VERSION;
+	ansnd_command_block.parameter_blocks = MEM_VIRTUAL_TO_PHYSICAL(ansnd_parameter_blocks);
+	ansnd_command_block.audio_buffers[0] = MEM_VIRTUAL_TO_PHYSICAL(ansnd_audio_buffer_out[0]);
+	ansnd_command_block.audio_buffers[1] = MEM_VIRTUAL_TO_PHYSICAL(ansnd_audio_buffer_out[1]);
+	ansnd_command_block.aux_buffers      = MEM_VIRTUAL_TO_PHYSICAL(ansnd_aux_buffer_out);
+	DCFlushRange(&ansnd_command_block, COMMAND_BLOCK_STRUCT_SIZE);
+	
+	DSP_SendMailTo(MEM_VIRTUAL_TO_PHYSICAL(&ansnd_command_block));
 }
 
 static void ansnd_dsp_resume_callback(dsptask_t* task) {
@@ -617,56 +2286,108 @@ static void ansnd_dsp_resume_callback(dsptask_t* task) {
 	
 	if (!ansnd_dsp_done_mixing) {
 		DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_NEXT);
-		while(DSP_CheckMailTo());
 	}
 }
 
 static void ansnd_dsp_request_callback(dsptask_t* task) {
 	ansnd_dsp_done_mixing = true;
 	ansnd_dsp_stalled = false;
+	ansnd_dsp_cycles++;
 	
 	ansnd_dsp_process_time = (gettime() - ansnd_dsp_start_time);
 	
-	ansnd_parameter_block_t* parameter_block_base = (ansnd_parameter_block_t*)ansnd_dsp_dram_image;
-	DCInvalidateRange(parameter_block_base, PARAMETER_BLOCK_STRUCT_SIZE * MAX_PARAMETER_BLOCKS);
+	// the DSP only wrote back the parameter blocks in the list it was given
+	for (u32 i = 0; i < ansnd_command_block.voice_count; ++i) {
+		DCInvalidateRange(&ansnd_parameter_blocks[ansnd_command_block.voices[i]], PARAMETER_BLOCK_STRUCT_SIZE);
+	}
 	
-	ansnd_active_voices = 0;
+	ansnd_active_voices  = 0;
+	ansnd_virtual_voices = 0;
 	
-	for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
+	// only voices that were changed or are playing need any work
+	u64 voices = ansnd_updated_voices | ansnd_running_voices;
+	ansnd_updated_voices = 0;
+	ansnd_running_voices = 0;
+	
+	u32 voice_count = 0;
+	
+	while (voices != 0) {
+		u32 i = __builtin_clzll(voices);
+		voices &= ~VOICE_BIT(i);
+		
 		ansnd_voice_t* voice = &ansnd_voices[i];
+		ansnd_update_voice(voice);
 		
-		if ((voice->flags & VOICE_FLAG_UPDATED) ||
-			((voice->parameter_block) && (voice->parameter_block->flags & VOICE_FLAG_FINISHED))) {
-			ansnd_sync_voice(voice);
+		// the DSP only loads the parameter blocks in this list, erased voices no longer have one
+		if (voice->parameter_block &&
+			(voice->parameter_block->flags & VOICE_FLAG_RUNNING)) {
+			ansnd_update_resample_table(voice, i);
+			ansnd_command_block.voices[voice_count++] = i;
 		}
 		
-		if (voice->flags & VOICE_FLAG_RUNNING) {
-			ansnd_active_voices++;
-		} else {
-			continue;
-		}
+		// by index, erased voices no longer point at their block
+		DCFlushRange(&ansnd_parameter_blocks[i], PARAMETER_BLOCK_STRUCT_SIZE);
 		
-		if ((voice->flags & VOICE_FLAG_STREAMING) &&
-			!(voice->flags & VOICE_FLAG_LOOPED)) {
-			ansnd_update_stream_buffers(voice);
+		// metered voices keep being visited so their meters fall to silence once stopped
+		if (voice->flags & VOICE_FLAG_UPDATED) {
+			ansnd_updated_voices |= VOICE_BIT(i);
 		}
-		
-		if (voice->flags & VOICE_FLAG_DELAY) {
-			ansnd_update_voice_delay(voice);
+		if ((voice->flags & VOICE_FLAG_RUNNING) ||
+			(voice->metering)) {
+			ansnd_running_voices |= VOICE_BIT(i);
 		}
 	}
 	
-	DCFlushRange(parameter_block_base, PARAMETER_BLOCK_STRUCT_SIZE * MAX_PARAMETER_BLOCKS);
+	ansnd_command_block.voice_count = voice_count;
+	
+	ansnd_update_group_ducking();
+	
+	if ((ansnd_callback_mode == ANSND_CALLBACK_MODE_THREAD) &&
+		(ansnd_callback_event_tail != ansnd_callback_event_head)) {
+		LWP_ThreadSignal(ansnd_callback_queue);
+	}
+	
+	DCFlushRange(&ansnd_command_block, COMMAND_BLOCK_STRUCT_SIZE);
 	
+	// the DSP fetches the command block and first parameter block of the next cycle on this,
+	// so nothing but the mix table may change in main memory until that cycle has run
 	DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_PREPARE);
-	while(DSP_CheckMailTo());
 	
 	ansnd_dsp_yielding = true;
 	
+	void* audio_buffer = ansnd_audio_buffer_out[ansnd_next_audio_buffer];
+	bool audio_buffer_invalidated = false;
+	
+	// effects returned from the aux buses end up in the final output before the audio callback sees it
+	for (u32 i = 0; i < ANSND_MAX_AUX_BUSES; ++i) {
+		if (ansnd_aux_callbacks[i]) {
+			if (!audio_buffer_invalidated) {
+				DCInvalidateRange(audio_buffer, ANSND_SOUND_BUFFER_SIZE);
+				audio_buffer_invalidated = true;
+			}
+			DCInvalidateRange(ansnd_aux_buffer_out[i], ANSND_SOUND_BUFFER_SIZE);
+			ansnd_aux_callbacks[i](i, ansnd_aux_buffer_out[i], audio_buffer, ANSND_SOUND_BUFFER_SIZE, ansnd_aux_callback_arguments[i]);
+		}
+	}
+	
+	if (ansnd_limiter.enabled) {
+		if (!audio_buffer_invalidated) {
+			DCInvalidateRange(audio_buffer, ANSND_SOUND_BUFFER_SIZE);
+			audio_buffer_invalidated = true;
+		}
+		ansnd_apply_limiter(audio_buffer, ANSND_SOUND_BUFFER_SIZE / 4);
+	}
+	
 	if (ansnd_audio_callback) {
-		DCInvalidateRange(ansnd_audio_buffer_out[ansnd_next_audio_buffer], ANSND_SOUND_BUFFER_SIZE);
-		ansnd_audio_callback(ansnd_audio_buffer_out[ansnd_next_audio_buffer], ANSND_SOUND_BUFFER_SIZE, ansnd_audio_callback_arguments);
-		DCFlushRange(ansnd_audio_buffer_out[ansnd_next_audio_buffer], ANSND_SOUND_BUFFER_SIZE);
+		if (!audio_buffer_invalidated) {
+			DCInvalidateRange(audio_buffer, ANSND_SOUND_BUFFER_SIZE);
+			audio_buffer_invalidated = true;
+		}
+		ansnd_audio_callback(audio_buffer, ANSND_SOUND_BUFFER_SIZE, ansnd_audio_callback_arguments);
+	}
+	
+	if (audio_buffer_invalidated) {
+		DCFlushRange(audio_buffer, ANSND_SOUND_BUFFER_SIZE);
 	}
 	
 	ansnd_total_process_time = (gettime() - ansnd_total_start_time);
@@ -686,170 +2407,1039 @@ static void ansnd_audio_dma_callback() {
 		return;
 	}
 	
-	ansnd_dsp_done_mixing = false;
+	ansnd_dsp_done_mixing = false;
+	
+	ansnd_total_start_time = gettime();
+	
+	if (ansnd_dsp_yielding) {
+		DSP_AssertTask(&ansnd_dsp_task);
+	} else {
+		DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_NEXT);
+	}
+	
+	ansnd_dsp_start_time = gettime();
+	
+	AUDIO_InitDMA((u32)ansnd_audio_buffer_out[ansnd_next_audio_buffer], ANSND_SOUND_BUFFER_SIZE);
+	
+	ansnd_next_audio_buffer ^= 1;
+}
+
+
+// --- External Interface --- //
+
+
+void ansnd_initialize() {
+	ansnd_initialize_samplerate(ANSND_OUTPUT_SAMPLERATE_48KHZ);
+}
+
+s32 ansnd_initialize_samplerate(u8 output_samplerate) {
+	u8 ai_rate;
+	switch (output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		ai_rate = AI_SAMPLERATE_32KHZ;
+		break;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		ai_rate = AI_SAMPLERATE_48KHZ;
+		break;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		ai_rate = AI_SAMPLERATE_96KHZ;
+		break;
+#endif
+	default:
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	ansnd_output_samplerate = output_samplerate;
+	
+	DSP_Init();
+	AUDIO_Init(NULL);
+	AUDIO_StopDMA();
+	AUDIO_SetDSPSampleRate(ai_rate);
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	if(!ansnd_library_initialized) {
+		ansnd_library_initialized = true;
+		
+		ansnd_dsp_done_mixing = false;
+		ansnd_dsp_stalled     = false;
+		ansnd_dsp_yielding    = false;
+		
+		memset(ansnd_voices, 0, sizeof(ansnd_voice_t) * ANSND_MAX_VOICES);
+		memset(ansnd_voice_setups, 0, sizeof(ansnd_voice_setup_t) * ANSND_MAX_VOICES);
+		for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
+			ansnd_voices[i].setup = &ansnd_voice_setups[i];
+		}
+		ansnd_updated_voices = 0;
+		ansnd_running_voices = 0;
+		memset(ansnd_voice_templates, 0, sizeof(ansnd_voice_template_t) * ANSND_MAX_VOICE_TEMPLATES);
+		
+		for (u32 i = 0; i < ANSND_MAX_VOICE_CLASSES; ++i) {
+			ansnd_voice_class_limits[i] = ANSND_MAX_VOICES;
+			ansnd_voice_class_counts[i] = 0;
+		}
+		ansnd_allocation_count = 0;
+		
+		// the lowest voices are handed out first
+		for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
+			ansnd_free_voices[i] = ANSND_MAX_VOICES - 1 - i;
+		}
+		ansnd_free_voice_count = ANSND_MAX_VOICES;
+		
+		for (u32 i = 0; i < ANSND_MAX_GROUPS; ++i) {
+			ansnd_groups[i].volume       = 1.f;
+			ansnd_groups[i].parent_group = ANSND_GROUP_MASTER;
+			ansnd_groups[i].muted        = false;
+			ansnd_groups[i].paused       = false;
+			ansnd_groups[i].ducking      = false;
+			ansnd_groups[i].duck_gain    = 1.f;
+		}
+		ansnd_wide_mix    = false;
+		ansnd_master_gain = 1.f;
+		memset(&ansnd_command_block, 0, sizeof(ansnd_command_block_t));
+		ansnd_update_mix_table();
+		
+		ansnd_command_block.resample_table_size  = ansnd_resample_table_size;
+		ansnd_command_block.resample_table_shift = -__builtin_ctz(ansnd_resample_table_size / 2);
+		
+		ansnd_virtualization           = false;
+		ansnd_virtualization_threshold = 0.f;
+		
+		ansnd_resample_tables_enabled = false;
+		
+		ansnd_callback_mode       = ANSND_CALLBACK_MODE_IMMEDIATE;
+		ansnd_callback_event_head = 0;
+		ansnd_callback_event_tail = 0;
+		
+		memset(&ansnd_limiter, 0, sizeof(ansnd_limiter_t));
+		
+		memset(ansnd_audio_buffer_out[0], 0, ANSND_SOUND_BUFFER_SIZE);
+		memset(ansnd_audio_buffer_out[1], 0, ANSND_SOUND_BUFFER_SIZE);
+		memset(ansnd_mute_buffer_out,     0, ANSND_SOUND_BUFFER_SIZE);
+		memset(ansnd_dsp_dram_image,      0, DSP_DRAM_SIZE);
+		memset(ansnd_parameter_blocks,    0, PARAMETER_BLOCK_STRUCT_SIZE * MAX_PARAMETER_BLOCKS);
+		
+		DCFlushRange(ansnd_audio_buffer_out[0], ANSND_SOUND_BUFFER_SIZE);
+		DCFlushRange(ansnd_audio_buffer_out[1], ANSND_SOUND_BUFFER_SIZE);
+		DCFlushRange(ansnd_mute_buffer_out,     ANSND_SOUND_BUFFER_SIZE);
+		DCFlushRange(ansnd_dsp_dram_image,      DSP_DRAM_SIZE);
+		DCFlushRange(ansnd_parameter_blocks,    PARAMETER_BLOCK_STRUCT_SIZE * MAX_PARAMETER_BLOCKS);
+		
+		ansnd_load_dsp_task();
+		do {
+			_CPU_ISR_Flash(level);
+		} while(ansnd_dsp_task.state != DSPTASK_RUN);
+	}
+	
+	AUDIO_RegisterDMACallback(ansnd_audio_dma_callback);
+	AUDIO_InitDMA((u32)ansnd_mute_buffer_out, ANSND_SOUND_BUFFER_SIZE);
+	AUDIO_StartDMA();
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+void ansnd_uninitialize() {
+	// the thread has to be joined with interrupts enabled
+	ansnd_stop_callback_thread();
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	if(ansnd_library_initialized) {
+		AUDIO_StopDMA();
+		AUDIO_RegisterDMACallback(NULL);
+		DSP_CancelTask(&ansnd_dsp_task);
+		
+		DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_END);
+		
+		do {
+			_CPU_ISR_Flash(level);
+		} while(ansnd_dsp_task.state != DSPTASK_DONE);
+		
+		// nothing reads swapped out tables once the task is done
+		free(ansnd_retired_resample_tables);
+		ansnd_retired_resample_tables = NULL;
+		
+		ansnd_library_initialized = false;
+	}
+	
+	_CPU_ISR_Restore(level);
+}
+
+s32 ansnd_allocate_voice() {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 voice_id = ansnd_allocate_voice_slot(ANSND_VOICE_PRIORITY_MAX, ANSND_VOICE_CLASS_DEFAULT, false, false);
+	
+	_CPU_ISR_Restore(level);
+	
+	return voice_id;
+}
+
+s32 ansnd_allocate_voice_with_priority(u8 priority, u8 voice_class, bool fade) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (voice_class >= ANSND_MAX_VOICE_CLASSES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 voice_id = ansnd_allocate_voice_slot(priority, voice_class, true, fade);
+	
+	_CPU_ISR_Restore(level);
+	
+	return voice_id;
+}
+
+s32 ansnd_set_voice_class_limit(u8 voice_class, u32 max_voices) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((voice_class >= ANSND_MAX_VOICE_CLASSES) ||
+		(max_voices > ANSND_MAX_VOICES)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_class_limits[voice_class] = max_voices;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_deallocate_voice(u32 voice_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_ERASED;
+	
+	if (linked_voice) {
+		voice->linked_voice = NULL;
+		linked_voice->linked_voice = NULL;
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+static s32 ansnd_validate_pcm_voice_config(const ansnd_pcm_voice_config_t* voice_config) {
+	if (voice_config == NULL) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	f32 max_samplerate = 1.f;
+	switch (ansnd_output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_32KHZ;
+		break;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_48KHZ;
+		break;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_96KHZ;
+		break;
+#endif
+	default:
+		break;
+	}
+	if (((voice_config->samplerate * voice_config->pitch) < 50) ||
+		((voice_config->samplerate * voice_config->pitch) > max_samplerate)) {
+		return ANSND_ERROR_INVALID_SAMPLERATE;
+	}
+	if ((voice_config->frame_data_ptr == 0) ||
+		(voice_config->frame_count == 0)) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#if defined(HW_DOL)
+	if ((voice_config->frame_data_ptr < AR_GetBaseAddress()) ||
+		(voice_config->frame_data_ptr >= AR_GetSize())) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#elif defined(HW_RVL)
+	if (voice_config->frame_data_ptr & SYS_BASE_CACHED) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#endif
+	if ((voice_config->format == ANSND_VOICE_PCM_FORMAT_UNSET) ||
+		(voice_config->format > ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->channels == 0) || (voice_config->channels > 2)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->left_volume < -1.f) || (voice_config->left_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->right_volume < -1.f) || (voice_config->right_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->envelope.sustain_level < 0.f) || (voice_config->envelope.sustain_level > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->loop_start_offset > voice_config->frame_count) ||
+		(voice_config->loop_end_offset > voice_config->frame_count)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	
+	return ANSND_ERROR_OK;
+}
+
+static void ansnd_apply_pcm_voice_config(ansnd_voice_t* voice, const ansnd_pcm_voice_config_t* voice_config, ansnd_parameter_block_t* parameter_block) {
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	ansnd_voice_allocation_t allocation = voice->allocation;
+	u32 steal_flags = voice->flags & (VOICE_FLAG_STOLEN | VOICE_FLAG_FADING);
+	ansnd_clear_voice(voice);
+	
+	voice->allocation = allocation;
+	voice->flags      = steal_flags;
+	
+	if (linked_voice) {
+		voice->linked_voice = linked_voice;
+	}
+	
+	u32 memory_shift = 0;
+	switch (voice_config->format) {
+	case ANSND_VOICE_PCM_FORMAT_SIGNED_8_PCM:
+		voice->setup->accelerator_format = DSP_ACCL_FMT_SIGNED_8BIT;
+		voice->setup->accelerator_gain   = DSP_ACCL_GAIN_8BIT;
+		break;
+	case ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM:
+		voice->setup->accelerator_format = DSP_ACCL_FMT_SIGNED_16BIT;
+		voice->setup->accelerator_gain   = DSP_ACCL_GAIN_16BIT;
+		memory_shift = 1;
+		break;
+	}
+	
+	voice->setup->samplerate = voice_config->samplerate;
+	voice->setup->pitch      = voice_config->pitch;
+	voice->setup->glide_time = 0;
+	
+	voice->delay = voice_config->delay;
+	
+	voice->flags |= VOICE_FLAG_USED;
+	voice->flags |= VOICE_FLAG_UPDATED;
+	voice->flags |= VOICE_FLAG_CONFIGURED;
+	
+	if (voice_config->channels == 2) {
+		voice->flags |= VOICE_FLAG_STEREO;
+	}
+	
+	voice->left_volume  = voice_config->left_volume;
+	voice->right_volume = voice_config->right_volume;
+	
+	if ((voice_config->envelope.attack_time != 0)  ||
+		(voice_config->envelope.decay_time != 0)   ||
+		(voice_config->envelope.sustain_level != 0.f) ||
+		(voice_config->envelope.release_time != 0)) {
+		voice->flags           |= VOICE_FLAG_ENVELOPE;
+		voice->setup->envelope = voice_config->envelope;
+	}
+	
+	voice->ram_buffer_start        = voice_config->frame_data_ptr >> memory_shift;
+	voice->setup->ram_buffer_end   = voice->ram_buffer_start + voice_config->frame_count * voice_config->channels - 1;
+	voice->setup->ram_buffer_first = voice->ram_buffer_start + voice_config->start_offset * voice_config->channels;
+	
+	if ((voice_config->loop_start_offset != 0) ||
+		(voice_config->loop_end_offset != 0)) {
+		voice->flags |= VOICE_FLAG_LOOPED;
+		
+		voice->setup->looping.loop_start = voice->ram_buffer_start + voice_config->loop_start_offset * voice_config->channels;
+		voice->setup->looping.loop_end   = voice->ram_buffer_start + voice_config->loop_end_offset * voice_config->channels - 1;
+	}
+	
+	voice->parameter_block = parameter_block;
+	
+	voice->voice_callback = voice_config->voice_callback;
+	
+	if (voice_config->stream_callback) {
+		voice->flags |= VOICE_FLAG_STREAMING;
+		voice->stream_callback.pcm_callback = voice_config->stream_callback;
+	}
+	
+	voice->user_pointer = voice_config->user_pointer;
+}
+
+s32 ansnd_configure_pcm_voice(u32 voice_id, const ansnd_pcm_voice_config_t* voice_config) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	s32 error = ansnd_validate_pcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_apply_pcm_voice_config(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)], voice_config, &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+	ansnd_mark_voice_updated(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)]);
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+static u32 ansnd_adpcm_offset_nibbles(const ansnd_adpcm_voice_config_t* voice_config, u32 offset) {
+	if (voice_config->nibble_offsets_flag != 0) {
+		return offset;
+	}
+	return SAMPLES_TO_NIBBLES(offset);
+}
+
+static s32 ansnd_validate_adpcm_voice_config(const ansnd_adpcm_voice_config_t* voice_config) {
+	if (voice_config == NULL) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	f32 max_samplerate = 1.f;
+	switch (ansnd_output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_32KHZ;
+		break;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_48KHZ;
+		break;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_96KHZ;
+		break;
+#endif
+	default:
+		break;
+	}
+	if (((voice_config->samplerate * voice_config->pitch) < 50) ||
+		((voice_config->samplerate * voice_config->pitch) > max_samplerate)) {
+		return ANSND_ERROR_INVALID_SAMPLERATE;
+	}
+	if ((voice_config->data_ptr == 0) ||
+		(voice_config->sample_count == 0)) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#if defined(HW_DOL)
+	if ((voice_config->data_ptr < AR_GetBaseAddress()) ||
+		(voice_config->data_ptr >= AR_GetSize())) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#elif defined(HW_RVL)
+	if (voice_config->data_ptr & SYS_BASE_CACHED) {
+		return ANSND_ERROR_INVALID_MEMORY;
+	}
+#endif
+	if ((voice_config->left_volume < -1.f) || (voice_config->left_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->right_volume < -1.f) || (voice_config->right_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	if ((voice_config->envelope.sustain_level < 0.f) || (voice_config->envelope.sustain_level > 1.f)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	
+	u32 end_offset_nibbles        = SAMPLES_TO_NIBBLES(voice_config->sample_count);
+	u32 loop_start_offset_nibbles = ansnd_adpcm_offset_nibbles(voice_config, voice_config->loop_start_offset);
+	u32 loop_end_offset_nibbles   = ansnd_adpcm_offset_nibbles(voice_config, voice_config->loop_end_offset);
+	
+	if ((loop_start_offset_nibbles > end_offset_nibbles) ||
+		(loop_end_offset_nibbles > end_offset_nibbles)) {
+		return ANSND_ERROR_INVALID_CONFIGURATION;
+	}
+	
+	return ANSND_ERROR_OK;
+}
+
+static void ansnd_apply_adpcm_voice_config(ansnd_voice_t* voice, const ansnd_adpcm_voice_config_t* voice_config, ansnd_parameter_block_t* parameter_block) {
+	u32 start_offset_nibbles      = ansnd_adpcm_offset_nibbles(voice_config, voice_config->start_offset);
+	u32 end_offset_nibbles        = SAMPLES_TO_NIBBLES(voice_config->sample_count);
+	u32 loop_start_offset_nibbles = ansnd_adpcm_offset_nibbles(voice_config, voice_config->loop_start_offset);
+	u32 loop_end_offset_nibbles   = ansnd_adpcm_offset_nibbles(voice_config, voice_config->loop_end_offset);
+	
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	ansnd_voice_allocation_t allocation = voice->allocation;
+	u32 steal_flags = voice->flags & (VOICE_FLAG_STOLEN | VOICE_FLAG_FADING);
+	ansnd_clear_voice(voice);
+	
+	voice->allocation = allocation;
+	voice->flags      = steal_flags;
+	
+	if (linked_voice) {
+		voice->linked_voice = linked_voice;
+	}
+	
+	if (voice_config->adpcm_format == DSP_ACCL_FMT_ADPCM) {
+		voice->flags |= VOICE_FLAG_ADPCM;
+	}
+	voice->setup->accelerator_format = voice_config->adpcm_format;
+	voice->setup->accelerator_gain   = voice_config->adpcm_gain;
+	
+	voice->setup->samplerate = voice_config->samplerate;
+	voice->setup->pitch      = voice_config->pitch;
+	voice->setup->glide_time = 0;
+	
+	voice->delay = voice_config->delay;
+	
+	voice->flags |= VOICE_FLAG_USED;
+	voice->flags |= VOICE_FLAG_UPDATED;
+	voice->flags |= VOICE_FLAG_CONFIGURED;
+	
+	voice->left_volume  = voice_config->left_volume;
+	voice->right_volume = voice_config->right_volume;
+	
+	if ((voice_config->envelope.attack_time != 0)  ||
+		(voice_config->envelope.decay_time != 0)   ||
+		(voice_config->envelope.sustain_level != 0.f) ||
+		(voice_config->envelope.release_time != 0)) {
+		voice->flags           |= VOICE_FLAG_ENVELOPE;
+		voice->setup->envelope = voice_config->envelope;
+	}
+	
+	for (u32 i = 0; i < 16; ++i) {
+		voice->setup->decode_coefficients[i] = voice_config->decode_coefficients[i];
+	}
+	
+	voice->ram_buffer_start        = voice_config->data_ptr << 1;
+	voice->setup->ram_buffer_end   = voice->ram_buffer_start + end_offset_nibbles;
+	voice->setup->ram_buffer_first = voice->ram_buffer_start + start_offset_nibbles;
+	
+	voice->setup->initial_predictor_scale  = voice_config->initial_predictor_scale;
+	voice->setup->initial_sample_history_1 = voice_config->initial_sample_history_1;
+	voice->setup->initial_sample_history_2 = voice_config->initial_sample_history_2;
+	
+	if (voice_config->loop_flag) {
+		voice->flags                     |= VOICE_FLAG_LOOPED;
+		voice->setup->looping.loop_start = voice->ram_buffer_start + loop_start_offset_nibbles;
+		voice->setup->looping.loop_end   = voice->ram_buffer_start + loop_end_offset_nibbles;
+		
+		voice->setup->looping.loop_predictor_scale  = voice_config->loop_predictor_scale;
+		voice->setup->looping.loop_sample_history_1 = voice_config->loop_sample_history_1;
+		voice->setup->looping.loop_sample_history_2 = voice_config->loop_sample_history_2;
+	}
+	
+	voice->parameter_block = parameter_block;
+	
+	voice->voice_callback = voice_config->voice_callback;
+	
+	if (voice_config->stream_callback) {
+		voice->flags |= VOICE_FLAG_STREAMING;
+		voice->stream_callback.adpcm_callback = voice_config->stream_callback;
+	}
+	
+	voice->user_pointer = voice_config->user_pointer;
+}
+
+s32 ansnd_configure_adpcm_voice(u32 voice_id, const ansnd_adpcm_voice_config_t* voice_config) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	s32 error = ansnd_validate_adpcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_apply_adpcm_voice_config(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)], voice_config, &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+	ansnd_mark_voice_updated(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)]);
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_play_pcm_one_shot(const ansnd_pcm_voice_config_t* voice_config, u8 priority, u8 voice_class, bool fade) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	if (voice_class >= ANSND_MAX_VOICE_CLASSES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	s32 error = ansnd_validate_pcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 voice_id = ansnd_allocate_voice_slot(priority, voice_class, true, fade);
+	if (voice_id >= 0) {
+		ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+		ansnd_apply_pcm_voice_config(voice, voice_config, &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+		voice->flags |= VOICE_FLAG_RUNNING | VOICE_FLAG_ONE_SHOT;
+		ansnd_mark_voice_updated(voice);
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return voice_id;
+}
+
+s32 ansnd_play_adpcm_one_shot(const ansnd_adpcm_voice_config_t* voice_config, u8 priority, u8 voice_class, bool fade) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	if (voice_class >= ANSND_MAX_VOICE_CLASSES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	s32 error = ansnd_validate_adpcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 voice_id = ansnd_allocate_voice_slot(priority, voice_class, true, fade);
+	if (voice_id >= 0) {
+		ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+		ansnd_apply_adpcm_voice_config(voice, voice_config, &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+		voice->flags |= VOICE_FLAG_RUNNING | VOICE_FLAG_ONE_SHOT;
+		ansnd_mark_voice_updated(voice);
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return voice_id;
+}
+
+s32 ansnd_create_pcm_voice_template(const ansnd_pcm_voice_config_t* voice_config) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	
+	s32 error = ansnd_validate_pcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 template_id = ansnd_find_voice_template();
+	if (template_id >= 0) {
+		ansnd_voice_template_t* voice_template = &ansnd_voice_templates[template_id];
+		voice_template->voice.setup = &voice_template->setup;
+		ansnd_clear_voice(&voice_template->voice);
+		ansnd_apply_pcm_voice_config(&voice_template->voice, voice_config, &voice_template->parameter_block);
+		ansnd_build_parameter_block(&voice_template->voice);
+		voice_template->used = true;
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return template_id;
+}
+
+s32 ansnd_create_adpcm_voice_template(const ansnd_adpcm_voice_config_t* voice_config) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	
+	s32 error = ansnd_validate_adpcm_voice_config(voice_config);
+	if (error != ANSND_ERROR_OK) {
+		return error;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 template_id = ansnd_find_voice_template();
+	if (template_id >= 0) {
+		ansnd_voice_template_t* voice_template = &ansnd_voice_templates[template_id];
+		voice_template->voice.setup = &voice_template->setup;
+		ansnd_clear_voice(&voice_template->voice);
+		ansnd_apply_adpcm_voice_config(&voice_template->voice, voice_config, &voice_template->parameter_block);
+		ansnd_build_parameter_block(&voice_template->voice);
+		voice_template->used = true;
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return template_id;
+}
+
+s32 ansnd_destroy_voice_template(u32 template_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((template_id >= ANSND_MAX_VOICE_TEMPLATES) ||
+		!ansnd_voice_templates[template_id].used) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_template_t* voice_template = &ansnd_voice_templates[template_id];
+	voice_template->used = false;
+	
+	// voices from the template build their parameter block themselves from now on
+	for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
+		if (ansnd_voices[i].parameter_block_image == &voice_template->parameter_block) {
+			ansnd_voices[i].parameter_block_image = NULL;
+		}
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_configure_voice_from_template(u32 voice_id, u32 template_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if ((template_id >= ANSND_MAX_VOICE_TEMPLATES) ||
+		!ansnd_voice_templates[template_id].used) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_apply_voice_template(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)], &ansnd_voice_templates[template_id], &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+	ansnd_mark_voice_updated(&ansnd_voices[VOICE_HANDLE_INDEX(voice_id)]);
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_play_template_one_shot(u32 template_id, u8 priority, u8 voice_class, bool fade) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	if ((voice_class >= ANSND_MAX_VOICE_CLASSES) ||
+		(template_id >= ANSND_MAX_VOICE_TEMPLATES) ||
+		!ansnd_voice_templates[template_id].used) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	s32 voice_id = ansnd_allocate_voice_slot(priority, voice_class, true, fade);
+	if (voice_id >= 0) {
+		ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+		ansnd_apply_voice_template(voice, &ansnd_voice_templates[template_id], &ansnd_parameter_blocks[VOICE_HANDLE_INDEX(voice_id)]);
+		voice->flags |= VOICE_FLAG_RUNNING | VOICE_FLAG_ONE_SHOT;
+		ansnd_mark_voice_updated(voice);
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return voice_id;
+}
+
+s32 ansnd_link_voices(u32 voice_id_1, u32 voice_id_2) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (voice_id_1 == voice_id_2) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id_1) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id_1)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (ansnd_voices[VOICE_HANDLE_INDEX(voice_id_1)].flags & VOICE_FLAG_RUNNING) {
+		return ANSND_ERROR_VOICE_RUNNING;
+	}
+	if (ansnd_voices[VOICE_HANDLE_INDEX(voice_id_1)].linked_voice) {
+		return ANSND_ERROR_VOICE_ALREADY_LINKED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id_2) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id_2)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (ansnd_voices[VOICE_HANDLE_INDEX(voice_id_2)].flags & VOICE_FLAG_RUNNING) {
+		return ANSND_ERROR_VOICE_RUNNING;
+	}
+	if (ansnd_voices[VOICE_HANDLE_INDEX(voice_id_2)].linked_voice) {
+		return ANSND_ERROR_VOICE_ALREADY_LINKED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_t* voice_1 = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id_1)];
+	ansnd_voice_t* voice_2 = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id_2)];
+	
+	voice_1->linked_voice = voice_2;
+	voice_2->linked_voice = voice_1;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_unlink_voice(u32 voice_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	if (!ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].linked_voice) {
+		return ANSND_ERROR_VOICE_NOT_LINKED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_t* voice_1 = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* voice_2 = voice_1->linked_voice;
+	
+	voice_1->linked_voice = NULL;
+	voice_2->linked_voice = NULL;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_start_voice(u32 voice_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	if ((ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_STREAMING) &&
+		(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_INITIALIZED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
 	
-	ansnd_total_start_time = gettime();
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
 	
-	if (ansnd_dsp_yielding) {
-		DSP_AssertTask(&ansnd_dsp_task);
-	} else {
-		DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_NEXT);
-		while(DSP_CheckMailTo());
-	}
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_RUNNING;
+	voice->flags &= ~(VOICE_FLAG_PAUSED | VOICE_FLAG_RELEASING);
+	voice->flags &= ~VOICE_FLAG_INITIALIZED;
 	
-	ansnd_dsp_start_time = gettime();
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_RUNNING;
+		linked_voice->flags &= ~(VOICE_FLAG_PAUSED | VOICE_FLAG_RELEASING);
+		linked_voice->flags &= ~VOICE_FLAG_INITIALIZED;
+	}
 	
-	AUDIO_InitDMA((u32)ansnd_audio_buffer_out[ansnd_next_audio_buffer], ANSND_SOUND_BUFFER_SIZE);
+	_CPU_ISR_Restore(level);
 	
-	ansnd_next_audio_buffer ^= 1;
-}
-
-
-// --- External Interface --- //
-
-
-void ansnd_initialize() {
-	ansnd_initialize_samplerate(ANSND_OUTPUT_SAMPLERATE_48KHZ);
+	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_initialize_samplerate(u8 output_samplerate) {
-	u8 ai_rate;
-	switch (output_samplerate) {
-	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
-		ai_rate = AI_SAMPLERATE_32KHZ;
-		break;
-	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
-		ai_rate = AI_SAMPLERATE_48KHZ;
-		break;
-#if defined(HW_DOL)
-	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
-		ai_rate = AI_SAMPLERATE_96KHZ;
-		break;
-#endif
-	default:
+s32 ansnd_stop_voice(u32 voice_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	ansnd_output_samplerate = output_samplerate;
-	
-	DSP_Init();
-	AUDIO_Init(NULL);
-	AUDIO_StopDMA();
-	AUDIO_SetDSPSampleRate(ai_rate);
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	if(!ansnd_library_initialized) {
-		ansnd_library_initialized = true;
-		
-		ansnd_dsp_done_mixing = false;
-		ansnd_dsp_stalled     = false;
-		ansnd_dsp_yielding    = false;
-		
-		memset(ansnd_voices, 0, sizeof(ansnd_voice_t) * ANSND_MAX_VOICES);
-		
-		memset(ansnd_audio_buffer_out[0], 0, ANSND_SOUND_BUFFER_SIZE);
-		memset(ansnd_audio_buffer_out[1], 0, ANSND_SOUND_BUFFER_SIZE);
-		memset(ansnd_mute_buffer_out,     0, ANSND_SOUND_BUFFER_SIZE);
-		memset(ansnd_dsp_dram_image,      0, DSP_DRAM_SIZE);
-		
-		DCFlushRange(ansnd_audio_buffer_out[0], ANSND_SOUND_BUFFER_SIZE);
-		DCFlushRange(ansnd_audio_buffer_out[1], ANSND_SOUND_BUFFER_SIZE);
-		DCFlushRange(ansnd_mute_buffer_out,     ANSND_SOUND_BUFFER_SIZE);
-		DCFlushRange(ansnd_dsp_dram_image,      DSP_DRAM_SIZE);
-		
-		ansnd_load_dsp_task();
-		do {
-			_CPU_ISR_Flash(level);
-		} while(ansnd_dsp_task.state != DSPTASK_RUN);
-	}
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
 	
-	AUDIO_RegisterDMACallback(ansnd_audio_dma_callback);
-	AUDIO_InitDMA((u32)ansnd_mute_buffer_out, ANSND_SOUND_BUFFER_SIZE);
-	AUDIO_StartDMA();
+	ansnd_release_voice(voice);
+	
+	if (linked_voice) {
+		ansnd_release_voice(linked_voice);
+	}
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-void ansnd_uninitialize() {
+s32 ansnd_pause_voice(u32 voice_id) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	if(ansnd_library_initialized) {
-		AUDIO_StopDMA();
-		AUDIO_RegisterDMACallback(NULL);
-		DSP_CancelTask(&ansnd_dsp_task);
-		
-		DSP_SendMailTo(DSP_MAIL_COMMAND | DSP_MAIL_END);
-		while(DSP_CheckMailTo());
-		
-		do {
-			_CPU_ISR_Flash(level);
-		} while(ansnd_dsp_task.state != DSPTASK_DONE);
-		
-		ansnd_library_initialized = false;
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_PAUSED;
+	
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_PAUSED;
 	}
 	
 	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_allocate_voice() {
+s32 ansnd_unpause_voice(u32 voice_id) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	s32 voice_id = -1;
-	for (u32 i = 0; i < ANSND_MAX_VOICES; ++i) {
-		if (!(ansnd_voices[i].flags & VOICE_FLAG_USED)) {
-			voice_id = i;
-			break;
-		}
-	}
-	
-	if (voice_id < 0) {
-		_CPU_ISR_Restore(level);
-		return ANSND_ERROR_ALL_VOICES_USED;
-	}
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	memset(voice, 0, sizeof(ansnd_voice_t));
+	ansnd_mark_voice_updated(voice);
+	voice->flags &= ~VOICE_FLAG_PAUSED;
 	
-	voice->flags = VOICE_FLAG_USED;
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags &= ~VOICE_FLAG_PAUSED;
+	}
 	
 	_CPU_ISR_Restore(level);
 	
-	return voice_id;
+	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_deallocate_voice(u32 voice_id) {
+s32 ansnd_stop_looping(u32 voice_id) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
+	if (!ansnd_voice_handle_valid(voice_id)) {
 		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_INITIALIZED)) {
+		return ANSND_ERROR_VOICE_NOT_INITIALIZED;
+	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
 	ansnd_voice_t* linked_voice = voice->linked_voice;
 	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags |= VOICE_FLAG_ERASED;
+	ansnd_mark_voice_updated(voice);
+	voice->flags &= ~VOICE_FLAG_LOOPED;
 	
 	if (linked_voice) {
-		voice->linked_voice = NULL;
-		linked_voice->linked_voice = NULL;
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags &= ~VOICE_FLAG_LOOPED;
 	}
 	
 	_CPU_ISR_Restore(level);
@@ -857,20 +3447,69 @@ s32 ansnd_deallocate_voice(u32 voice_id) {
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_configure_pcm_voice(u32 voice_id, const ansnd_pcm_voice_config_t* voice_config) {
+s32 ansnd_set_voice_volume(u32 voice_id, f32 left_volume, f32 right_volume) {
+	return ansnd_set_voice_volume_ramp(voice_id, left_volume, right_volume, 0);
+}
+
+s32 ansnd_set_voice_volume_ramp(u32 voice_id, f32 left_volume, f32 right_volume, u32 ramp_time) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
+	if (!ansnd_voice_handle_valid(voice_id)) {
 		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
-	if (voice_config == NULL) {
+	if (!(ansnd_voices[VOICE_HANDLE_INDEX(voice_id)].flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	if ((left_volume < -1.f) || (left_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if ((right_volume < -1.f) || (right_volume > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_VOLUME_CHANGE;
+	
+	voice->left_volume             = left_volume;
+	voice->right_volume            = right_volume;
+	voice->setup->volume_ramp_time = ramp_time;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_voice_pitch(u32 voice_id, f32 pitch) {
+	return ansnd_glide_voice_pitch(voice_id, pitch, 0, ANSND_GLIDE_MODE_LINEAR);
+}
+
+s32 ansnd_glide_voice_pitch(u32 voice_id, f32 pitch, u32 glide_time, u8 glide_mode) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) ||
+		(glide_mode > ANSND_GLIDE_MODE_EXPONENTIAL)) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
 	f32 max_samplerate = 1.f;
 	switch (ansnd_output_samplerate) {
 	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
@@ -887,437 +3526,531 @@ s32 ansnd_configure_pcm_voice(u32 voice_id, const ansnd_pcm_voice_config_t* voic
 	default:
 		break;
 	}
-	if (((voice_config->samplerate * voice_config->pitch) < 50) ||
-		((voice_config->samplerate * voice_config->pitch) > max_samplerate)) {
+	if (((voice->setup->samplerate * pitch) < 50) ||
+		((voice->setup->samplerate * pitch * powf(2.f, voice->setup->lfo_pitch_depth / 12.f)) > max_samplerate)) {
 		return ANSND_ERROR_INVALID_SAMPLERATE;
 	}
-	if ((voice_config->frame_data_ptr == 0) ||
-		(voice_config->frame_count == 0)) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_PITCH_CHANGE;
+	
+	voice->setup->pitch      = pitch;
+	voice->setup->glide_time = glide_time;
+	voice->setup->glide_mode = glide_mode;
+	
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_PITCH_CHANGE;
+		
+		linked_voice->setup->pitch      = pitch;
+		linked_voice->setup->glide_time = glide_time;
+		linked_voice->setup->glide_mode = glide_mode;
 	}
-#if defined(HW_DOL)
-	if ((voice_config->frame_data_ptr < AR_GetBaseAddress()) ||
-		(voice_config->frame_data_ptr >= AR_GetSize())) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_voice_lfo(u32 voice_id, u8 shape, f32 rate, f32 pitch_depth, f32 volume_depth) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-#elif defined(HW_RVL)
-	if (voice_config->frame_data_ptr & SYS_BASE_CACHED) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
 	}
+	f32 max_rate = 1000000.f / (2 * ansnd_microseconds_per_cycle());
+	f32 max_samplerate = 1.f;
+	switch (ansnd_output_samplerate) {
+	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_32KHZ;
+		break;
+	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_48KHZ;
+		break;
+#if defined(HW_DOL)
+	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
+		max_samplerate = ANSND_MAX_SAMPLERATE_96KHZ;
+		break;
 #endif
-	if ((voice_config->format == ANSND_VOICE_PCM_FORMAT_UNSET) ||
-		(voice_config->format > ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	default:
+		break;
 	}
-	if ((voice_config->channels == 0) || (voice_config->channels > 2)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if (shape > ANSND_LFO_SHAPE_SQUARE) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_config->left_volume < -1.f) || (voice_config->left_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if ((rate < 0.f) || (rate > max_rate)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_config->right_volume < -1.f) || (voice_config->right_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if ((pitch_depth < 0.f) || (pitch_depth > 12.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_config->loop_start_offset > voice_config->frame_count) ||
-		(voice_config->loop_end_offset > voice_config->frame_count)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if ((volume_depth < 0.f) || (volume_depth > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if ((voice->setup->samplerate * voice->setup->pitch * powf(2.f, pitch_depth / 12.f)) > max_samplerate) {
+		return ANSND_ERROR_INVALID_SAMPLERATE;
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	memset(voice, 0, sizeof(ansnd_voice_t));
-	
-	if (linked_voice) {
-		voice->linked_voice = linked_voice;
-	}
-	
-	u32 memory_shift = 0;
-	switch (voice_config->format) {
-	case ANSND_VOICE_PCM_FORMAT_SIGNED_8_PCM:
-		voice->accelerator_format = DSP_ACCL_FMT_SIGNED_8BIT;
-		voice->accelerator_gain   = DSP_ACCL_GAIN_8BIT;
-		break;
-	case ANSND_VOICE_PCM_FORMAT_SIGNED_16_PCM:
-		voice->accelerator_format = DSP_ACCL_FMT_SIGNED_16BIT;
-		voice->accelerator_gain   = DSP_ACCL_GAIN_16BIT;
-		memory_shift = 1;
-		break;
-	}
-	
-	voice->samplerate = voice_config->samplerate;
-	voice->pitch      = voice_config->pitch;
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_LFO_CHANGE;
 	
-	voice->delay = voice_config->delay;
-	
-	voice->flags |= VOICE_FLAG_USED;
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags |= VOICE_FLAG_CONFIGURED;
-	
-	if (voice_config->channels == 2) {
-		voice->flags |= VOICE_FLAG_STEREO;
-	}
-	
-	voice->left_volume  = voice_config->left_volume;
-	voice->right_volume = voice_config->right_volume;
+	voice->lfo_shape               = shape;
+	voice->setup->lfo_rate         = rate;
+	voice->setup->lfo_pitch_depth  = pitch_depth;
+	voice->setup->lfo_volume_depth = volume_depth;
 	
-	voice->ram_buffer_start = voice_config->frame_data_ptr >> memory_shift;
-	voice->ram_buffer_end   = voice->ram_buffer_start + voice_config->frame_count * voice_config->channels - 1;
-	voice->ram_buffer_first = voice->ram_buffer_start + voice_config->start_offset * voice_config->channels;
-	
-	if ((voice_config->loop_start_offset != 0) ||
-		(voice_config->loop_end_offset != 0)) {
-		voice->flags |= VOICE_FLAG_LOOPED;
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_LFO_CHANGE;
 		
-		voice->looping.loop_start = voice->ram_buffer_start + voice_config->loop_start_offset * voice_config->channels;
-		voice->looping.loop_end   = voice->ram_buffer_start + voice_config->loop_end_offset * voice_config->channels - 1;
-	}
-	
-	ansnd_parameter_block_t* parameter_block_base = (ansnd_parameter_block_t*)ansnd_dsp_dram_image;
-	voice->parameter_block = &parameter_block_base[voice_id];
-	
-	voice->voice_callback = voice_config->voice_callback;
-	
-	if (voice_config->stream_callback) {
-		voice->flags |= VOICE_FLAG_STREAMING;
-		voice->stream_callback.pcm_callback = voice_config->stream_callback;
+		linked_voice->lfo_shape               = shape;
+		linked_voice->setup->lfo_rate         = rate;
+		linked_voice->setup->lfo_pitch_depth  = pitch_depth;
+		linked_voice->setup->lfo_volume_depth = volume_depth;
 	}
 	
-	voice->user_pointer = voice_config->user_pointer;
-	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_configure_adpcm_voice(u32 voice_id, const ansnd_adpcm_voice_config_t* voice_config) {
+s32 ansnd_set_voice_biquad(u32 voice_id, u8 type, f32 cutoff, f32 q) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
+	if (!ansnd_voice_handle_valid(voice_id)) {
 		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
-	if (voice_config == NULL) {
-		return ANSND_ERROR_INVALID_INPUT;
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
 	}
-	f32 max_samplerate = 1.f;
+	f32 dsp_frequency = 1.f;
 	switch (ansnd_output_samplerate) {
 	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_32KHZ;
+		dsp_frequency = ANSND_DSP_FREQ_32KHZ;
 		break;
 	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_48KHZ;
+		dsp_frequency = ANSND_DSP_FREQ_48KHZ;
 		break;
 #if defined(HW_DOL)
 	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_96KHZ;
+		dsp_frequency = ANSND_DSP_FREQ_96KHZ;
 		break;
 #endif
 	default:
 		break;
 	}
-	if (((voice_config->samplerate * voice_config->pitch) < 50) ||
-		((voice_config->samplerate * voice_config->pitch) > max_samplerate)) {
-		return ANSND_ERROR_INVALID_SAMPLERATE;
+	if (type > ANSND_BIQUAD_TYPE_BAND_PASS) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_config->data_ptr == 0) ||
-		(voice_config->sample_count == 0)) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	if ((type != ANSND_BIQUAD_TYPE_OFF) &&
+		((cutoff < 10.f) || (cutoff > (dsp_frequency * 0.45f)) || (q < 0.1f) || (q > 20.f))) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-#if defined(HW_DOL)
-	if ((voice_config->data_ptr < AR_GetBaseAddress()) ||
-		(voice_config->data_ptr >= AR_GetSize())) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_BIQUAD_CHANGE;
+	
+	voice->biquad_type          = type;
+	voice->setup->biquad_cutoff = cutoff;
+	voice->setup->biquad_q      = q;
+	
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_BIQUAD_CHANGE;
+		
+		linked_voice->biquad_type          = type;
+		linked_voice->setup->biquad_cutoff = cutoff;
+		linked_voice->setup->biquad_q      = q;
 	}
-#elif defined(HW_RVL)
-	if (voice_config->data_ptr & SYS_BASE_CACHED) {
-		return ANSND_ERROR_INVALID_MEMORY;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_voice_resample_quality(u32 voice_id, u8 quality) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-#endif
-	if ((voice_config->left_volume < -1.f) || (voice_config->left_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if ((VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) ||
+		(quality > ANSND_RESAMPLE_QUALITY_CUBIC)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_config->right_volume < -1.f) || (voice_config->right_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
 	
-	u32 start_offset_nibbles      = 0;
-	u32 end_offset_nibbles        = SAMPLES_TO_NIBBLES(voice_config->sample_count);
-	u32 loop_start_offset_nibbles = 0;
-	u32 loop_end_offset_nibbles   = 0;
-	if (voice_config->nibble_offsets_flag != 0) {
-		start_offset_nibbles      = voice_config->start_offset;
-		loop_start_offset_nibbles = voice_config->loop_start_offset;
-		loop_end_offset_nibbles   = voice_config->loop_end_offset;
-	} else {
-		start_offset_nibbles      = SAMPLES_TO_NIBBLES(voice_config->start_offset);
-		loop_start_offset_nibbles = SAMPLES_TO_NIBBLES(voice_config->loop_start_offset);
-		loop_end_offset_nibbles   = SAMPLES_TO_NIBBLES(voice_config->loop_end_offset);
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
 	}
 	
-	if ((loop_start_offset_nibbles > end_offset_nibbles) ||
-		(loop_end_offset_nibbles > end_offset_nibbles)) {
-		return ANSND_ERROR_INVALID_CONFIGURATION;
+	// cubic resampling always runs from a table
+	if (quality == ANSND_RESAMPLE_QUALITY_CUBIC) {
+		s32 error = ansnd_allocate_resample_tables(ansnd_resample_table_phases);
+		if (error != ANSND_ERROR_OK) {
+			return error;
+		}
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	memset(voice, 0, sizeof(ansnd_voice_t));
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_RESAMPLE_CHANGE;
+	
+	voice->resample_quality = quality;
 	
 	if (linked_voice) {
-		voice->linked_voice = linked_voice;
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_RESAMPLE_CHANGE;
+		
+		linked_voice->resample_quality = quality;
 	}
 	
-	if (voice_config->adpcm_format == DSP_ACCL_FMT_ADPCM) {
-		voice->flags |= VOICE_FLAG_ADPCM;
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_voice_aux_send(u32 voice_id, u8 aux_bus, f32 send_level) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) ||
+		(aux_bus >= ANSND_MAX_AUX_BUSES) ||
+		(send_level < 0.f) ||
+		(send_level > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
-	voice->accelerator_format = voice_config->adpcm_format;
-	voice->accelerator_gain   = voice_config->adpcm_gain;
 	
-	voice->samplerate = voice_config->samplerate;
-	voice->pitch      = voice_config->pitch;
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
 	
-	voice->delay = voice_config->delay;
+	u32 level;
+	_CPU_ISR_Disable(level);
 	
-	voice->flags |= VOICE_FLAG_USED;
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags |= VOICE_FLAG_CONFIGURED;
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_AUX_CHANGE;
 	
-	voice->left_volume  = voice_config->left_volume;
-	voice->right_volume = voice_config->right_volume;
+	voice->setup->aux_send[aux_bus] = send_level;
 	
-	for (u32 i = 0; i < 16; ++i) {
-		voice->decode_coefficients[i] = voice_config->decode_coefficients[i];
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_AUX_CHANGE;
+		
+		linked_voice->setup->aux_send[aux_bus] = send_level;
 	}
 	
-	voice->ram_buffer_start = voice_config->data_ptr << 1;
-	voice->ram_buffer_end   = voice->ram_buffer_start + end_offset_nibbles;
-	voice->ram_buffer_first = voice->ram_buffer_start + start_offset_nibbles;
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_voice_group(u32 voice_id, u8 group) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) ||
+		(group >= ANSND_MAX_GROUPS)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
 	
-	voice->initial_predictor_scale  = voice_config->initial_predictor_scale;
-	voice->initial_sample_history_1 = voice_config->initial_sample_history_1;
-	voice->initial_sample_history_2 = voice_config->initial_sample_history_2;
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
 	
-	if (voice_config->loop_flag) {
-		voice->flags              |= VOICE_FLAG_LOOPED;
-		voice->looping.loop_start = voice->ram_buffer_start + loop_start_offset_nibbles;
-		voice->looping.loop_end   = voice->ram_buffer_start + loop_end_offset_nibbles;
-		
-		voice->looping.loop_predictor_scale  = voice_config->loop_predictor_scale;
-		voice->looping.loop_sample_history_1 = voice_config->loop_sample_history_1;
-		voice->looping.loop_sample_history_2 = voice_config->loop_sample_history_2;
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
 	}
 	
-	ansnd_parameter_block_t* parameter_block_base = (ansnd_parameter_block_t*)ansnd_dsp_dram_image;
-	voice->parameter_block = &parameter_block_base[voice_id];
+	u32 level;
+	_CPU_ISR_Disable(level);
 	
-	voice->voice_callback = voice_config->voice_callback;
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_GROUP_CHANGE;
 	
-	if (voice_config->stream_callback) {
-		voice->flags |= VOICE_FLAG_STREAMING;
-		voice->stream_callback.adpcm_callback = voice_config->stream_callback;
-	}
+	voice->group = group;
 	
-	voice->user_pointer = voice_config->user_pointer;
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_GROUP_CHANGE;
+		
+		linked_voice->group = group;
+	}
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_link_voices(u32 voice_id_1, u32 voice_id_2) {
+s32 ansnd_set_voice_metering(u32 voice_id, bool enabled) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (voice_id_1 == voice_id_2) {
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if ((voice_id_1 < 0) ||
-		(voice_id_1 >= ANSND_MAX_VOICES)) {
+	if (!ansnd_voice_handle_valid(voice_id)) {
+		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	}
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	ansnd_voice_t* linked_voice = voice->linked_voice;
+	
+	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
+		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_mark_voice_updated(voice);
+	voice->flags |= VOICE_FLAG_METER_CHANGE;
+	
+	voice->metering   = enabled;
+	voice->meter_peak = 0.f;
+	voice->meter_rms  = 0.f;
+	
+	if (linked_voice) {
+		ansnd_mark_voice_updated(linked_voice);
+		linked_voice->flags |= VOICE_FLAG_METER_CHANGE;
+		
+		linked_voice->metering   = enabled;
+		linked_voice->meter_peak = 0.f;
+		linked_voice->meter_rms  = 0.f;
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_get_voice_meter(u32 voice_id, f32* peak, f32* rms) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (VOICE_HANDLE_INDEX(voice_id) >= ANSND_MAX_VOICES) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id_1].flags & VOICE_FLAG_USED)) {
+	if (!ansnd_voice_handle_valid(voice_id)) {
 		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
 	}
-	if (ansnd_voices[voice_id_1].flags & VOICE_FLAG_RUNNING) {
-		return ANSND_ERROR_VOICE_RUNNING;
+	
+	ansnd_voice_t* voice = &ansnd_voices[VOICE_HANDLE_INDEX(voice_id)];
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	if (peak) {
+		*peak = voice->meter_peak;
 	}
-	if (ansnd_voices[voice_id_1].linked_voice) {
-		return ANSND_ERROR_VOICE_ALREADY_LINKED;
+	if (rms) {
+		*rms = voice->meter_rms;
+	}
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_group_parent(u8 group, u8 parent_group) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id_2 < 0) ||
-		(voice_id_2 >= ANSND_MAX_VOICES)) {
+	if ((group == ANSND_GROUP_MASTER) ||
+		(group >= ANSND_MAX_GROUPS) ||
+		(parent_group >= group)) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id_2].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_groups[group].parent_group = parent_group;
+	ansnd_update_mix_table();
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_group_volume(u8 group, f32 volume) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (ansnd_voices[voice_id_2].flags & VOICE_FLAG_RUNNING) {
-		return ANSND_ERROR_VOICE_RUNNING;
+	if ((group >= ANSND_MAX_GROUPS) ||
+		(volume < 0.f) ||
+		(volume > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_groups[group].volume = volume;
+	ansnd_update_mix_table();
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_mute_group(u8 group) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (ansnd_voices[voice_id_2].linked_voice) {
-		return ANSND_ERROR_VOICE_ALREADY_LINKED;
+	if (group >= ANSND_MAX_GROUPS) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice_1 = &ansnd_voices[voice_id_1];
-	ansnd_voice_t* voice_2 = &ansnd_voices[voice_id_2];
-	
-	voice_1->linked_voice = voice_2;
-	voice_2->linked_voice = voice_1;
+	ansnd_groups[group].muted = true;
+	ansnd_update_mix_table();
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_unlink_voice(u32 voice_id) {
+s32 ansnd_unmute_group(u8 group) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (group >= ANSND_MAX_GROUPS) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
-	if (!ansnd_voices[voice_id].linked_voice) {
-		return ANSND_ERROR_VOICE_NOT_LINKED;
-	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice_1 = &ansnd_voices[voice_id];
-	ansnd_voice_t* voice_2 = voice_1->linked_voice;
-	
-	voice_1->linked_voice = NULL;
-	voice_2->linked_voice = NULL;
+	ansnd_groups[group].muted = false;
+	ansnd_update_mix_table();
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_start_voice(u32 voice_id) {
+s32 ansnd_pause_group(u8 group) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (ansnd_dsp_stalled) {
-		return ANSND_ERROR_DSP_STALLED;
-	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (group >= ANSND_MAX_GROUPS) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
-	if ((ansnd_voices[voice_id].flags & VOICE_FLAG_STREAMING) &&
-		(ansnd_voices[voice_id].flags & VOICE_FLAG_INITIALIZED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	
-	voice->flags |= VOICE_FLAG_UPDATED | VOICE_FLAG_RUNNING;
-	voice->flags &= ~VOICE_FLAG_PAUSED;
-	voice->flags &= ~VOICE_FLAG_INITIALIZED;
-	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED | VOICE_FLAG_RUNNING;
-		linked_voice->flags &= ~VOICE_FLAG_PAUSED;
-		linked_voice->flags &= ~VOICE_FLAG_INITIALIZED;
-	}
+	ansnd_groups[group].paused = true;
+	ansnd_update_mix_table();
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_stop_voice(u32 voice_id) {
+s32 ansnd_unpause_group(u8 group) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if (group >= ANSND_MAX_GROUPS) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags &= ~VOICE_FLAG_RUNNING;
-	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED;
-		linked_voice->flags &= ~VOICE_FLAG_RUNNING;
-	}
+	ansnd_groups[group].paused = false;
+	ansnd_update_mix_table();
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_pause_voice(u32 voice_id) {
+s32 ansnd_set_group_ducking(u8 group, bool enabled, u8 key_group, f32 ducked_volume, f32 threshold, u32 attack_time, u32 release_time) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if ((group >= ANSND_MAX_GROUPS) ||
+		(key_group >= ANSND_MAX_GROUPS) ||
+		(key_group == group) ||
+		(ducked_volume < 0.f) ||
+		(ducked_volume > 1.f) ||
+		(threshold < 0.f) ||
+		(threshold > 1.f)) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
+	
+	u32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
+	// the duck gain is smoothed once per cycle, a time of 0 follows the key immediately
+	f32 attack_coefficient  = 0.f;
+	f32 release_coefficient = 0.f;
+	if (attack_time != 0) {
+		attack_coefficient = expf(-(f32)microseconds_per_cycle / attack_time);
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	if (release_time != 0) {
+		release_coefficient = expf(-(f32)microseconds_per_cycle / release_time);
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags |= VOICE_FLAG_PAUSED;
+	ansnd_group_t* ducked_group = &ansnd_groups[group];
 	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED;
-		linked_voice->flags |= VOICE_FLAG_PAUSED;
+	ducked_group->ducking             = enabled;
+	ducked_group->key_group           = key_group;
+	ducked_group->ducked_volume       = ducked_volume;
+	ducked_group->threshold           = threshold;
+	ducked_group->attack_coefficient  = attack_coefficient;
+	ducked_group->release_coefficient = release_coefficient;
+	if (!enabled) {
+		ducked_group->duck_gain = 1.f;
+		ansnd_update_mix_table();
 	}
 	
 	_CPU_ISR_Restore(level);
@@ -1325,266 +4058,277 @@ s32 ansnd_pause_voice(u32 voice_id) {
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_unpause_voice(u32 voice_id) {
+s32 ansnd_get_dsp_usage_percent(f32* dsp_usage) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
 	if (ansnd_dsp_stalled) {
 		return ANSND_ERROR_DSP_STALLED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
-		return ANSND_ERROR_INVALID_INPUT;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	if (!dsp_usage) {
+		return ANSND_ERROR_OK;
 	}
 	
+	f32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
-	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags &= ~VOICE_FLAG_PAUSED;
-	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED;
-		linked_voice->flags &= ~VOICE_FLAG_PAUSED;
-	}
+	*dsp_usage = ticks_to_microsecs(ansnd_dsp_process_time) / microseconds_per_cycle;
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_stop_looping(u32 voice_id) {
+s32 ansnd_get_total_usage_percent(f32* total_usage) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
-		return ANSND_ERROR_INVALID_INPUT;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
+	if (ansnd_dsp_stalled) {
+		return ANSND_ERROR_DSP_STALLED;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_INITIALIZED)) {
-		return ANSND_ERROR_VOICE_NOT_INITIALIZED;
+	if (!total_usage) {
+		return ANSND_ERROR_OK;
 	}
 	
+	f32 microseconds_per_cycle = ansnd_microseconds_per_cycle();
+	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
+	*total_usage = ticks_to_microsecs(ansnd_total_process_time) / microseconds_per_cycle;
 	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags &= ~VOICE_FLAG_LOOPED;
+	_CPU_ISR_Restore(level);
 	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED;
-		linked_voice->flags &= ~VOICE_FLAG_LOOPED;
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_get_total_active_voices(u32* active_voices) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if (!active_voices) {
+		return ANSND_ERROR_OK;
 	}
 	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	*active_voices = ansnd_active_voices;
+	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_set_voice_volume(u32 voice_id, f32 left_volume, f32 right_volume) {
+s32 ansnd_get_total_virtual_voices(u32* virtual_voices) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
-		return ANSND_ERROR_INVALID_INPUT;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
-	if ((left_volume < -1.f) || (left_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_INPUT;
-	}
-	if ((right_volume < -1.f) || (right_volume > 1.f)) {
-		return ANSND_ERROR_INVALID_INPUT;
+	if (!virtual_voices) {
+		return ANSND_ERROR_OK;
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	
-	voice->left_volume = left_volume;
-	voice->right_volume = right_volume;
+	*virtual_voices = ansnd_virtual_voices;
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_set_voice_pitch(u32 voice_id, f32 pitch) {
+s32 ansnd_set_virtualization(bool enabled, f32 threshold) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if ((voice_id < 0) ||
-		(voice_id >= ANSND_MAX_VOICES)) {
+	if ((threshold < 0.f) ||
+		(threshold > 1.f)) {
 		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (!(ansnd_voices[voice_id].flags & VOICE_FLAG_USED)) {
-		return ANSND_ERROR_VOICE_ID_NOT_ALLOCATED;
-	}
 	
-	ansnd_voice_t* voice = &ansnd_voices[voice_id];
-	ansnd_voice_t* linked_voice = voice->linked_voice;
+	u32 level;
+	_CPU_ISR_Disable(level);
 	
-	if (!(voice->flags & VOICE_FLAG_CONFIGURED)) {
-		return ANSND_ERROR_VOICE_NOT_CONFIGURED;
-	}
-	if (voice->flags & VOICE_FLAG_RUNNING) {
-		return ANSND_ERROR_VOICE_RUNNING;
+	ansnd_virtualization           = enabled;
+	ansnd_virtualization_threshold = threshold;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_resample_tables(bool enabled, u16 phases) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	f32 max_samplerate = 1.f;
-	switch (ansnd_output_samplerate) {
-	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_32KHZ;
-		break;
-	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_48KHZ;
-		break;
-#if defined(HW_DOL)
-	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
-		max_samplerate = ANSND_MAX_SAMPLERATE_96KHZ;
-		break;
-#endif
-	default:
-		break;
+	if ((phases < RESAMPLE_TABLE_MIN_PHASES) ||
+		(phases > RESAMPLE_TABLE_MAX_PHASES) ||
+		(phases & (phases - 1))) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
-	if (((voice->samplerate * pitch) < 50) ||
-		((voice->samplerate * pitch) > max_samplerate)) {
-		return ANSND_ERROR_INVALID_SAMPLERATE;
+	
+	// tables that are already there for cubic voices follow the new phase count too
+	if (enabled || ansnd_resample_tables) {
+		s32 error = ansnd_allocate_resample_tables(phases);
+		if (error != ANSND_ERROR_OK) {
+			return error;
+		}
+	} else {
+		ansnd_resample_table_phases = phases;
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	voice->flags |= VOICE_FLAG_UPDATED;
-	voice->flags |= VOICE_FLAG_PITCH_CHANGE;
+	// tables are built or dropped when the voices are next mixed
+	ansnd_resample_tables_enabled = enabled;
 	
-	voice->pitch = pitch;
+	_CPU_ISR_Restore(level);
 	
-	if (linked_voice) {
-		linked_voice->flags |= VOICE_FLAG_UPDATED;
-		linked_voice->flags |= VOICE_FLAG_PITCH_CHANGE;
-		
-		linked_voice->pitch = pitch;
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_wide_mix(bool enabled, f32 master_gain) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((master_gain < 0.f) ||
+		(master_gain > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
 	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_wide_mix    = enabled;
+	ansnd_master_gain = master_gain;
+	ansnd_update_mix_table();
+	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_get_dsp_usage_percent(f32* dsp_usage) {
+s32 ansnd_set_callback_mode(u8 mode, u8 thread_priority) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (ansnd_dsp_stalled) {
-		return ANSND_ERROR_DSP_STALLED;
-	}
-	if (!dsp_usage) {
-		return ANSND_ERROR_OK;
+	if ((mode > ANSND_CALLBACK_MODE_THREAD) ||
+		(thread_priority > LWP_PRIO_HIGHEST)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
 	
-	f32 microseconds_per_cycle = 1.f;
-	switch (ansnd_output_samplerate) {
-	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
-		microseconds_per_cycle = 7500.f;
-		break;
-	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
-		microseconds_per_cycle = 5000.f;
-		break;
-#if defined(HW_DOL)
-	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
-		microseconds_per_cycle = 2500.f;
-		break;
-#endif
-	default:
-		break;
-	}
+	ansnd_stop_callback_thread();
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	*dsp_usage = ticks_to_microsecs(ansnd_dsp_process_time) / microseconds_per_cycle;
+	ansnd_callback_mode = mode;
 	
 	_CPU_ISR_Restore(level);
 	
+	if (mode == ANSND_CALLBACK_MODE_THREAD) {
+		if (!ansnd_start_callback_thread(thread_priority)) {
+			_CPU_ISR_Disable(level);
+			ansnd_callback_mode = ANSND_CALLBACK_MODE_IMMEDIATE;
+			_CPU_ISR_Restore(level);
+			
+			ansnd_dispatch_callback_events();
+			return ANSND_ERROR_THREAD_FAILED;
+		}
+	} else if (mode == ANSND_CALLBACK_MODE_IMMEDIATE) {
+		// nothing will drain the queue anymore
+		ansnd_dispatch_callback_events();
+	}
+	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_get_total_usage_percent(f32* total_usage) {
+s32 ansnd_dispatch_callbacks() {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (ansnd_dsp_stalled) {
-		return ANSND_ERROR_DSP_STALLED;
+	
+	if (ansnd_callback_mode == ANSND_CALLBACK_MODE_POLLED) {
+		ansnd_dispatch_callback_events();
 	}
-	if (!total_usage) {
-		return ANSND_ERROR_OK;
+	
+	return ANSND_ERROR_OK;
+}
+
+s32 ansnd_set_limiter(bool enabled, f32 input_gain, f32 threshold, u32 release_time) {
+	if (!ansnd_library_initialized) {
+		return ANSND_ERROR_NOT_INITIALIZED;
+	}
+	if ((input_gain < 1.f) ||
+		(input_gain > 16.f) ||
+		(threshold <= 0.f) ||
+		(threshold > 1.f)) {
+		return ANSND_ERROR_INVALID_INPUT;
 	}
 	
-	f32 microseconds_per_cycle = 1.f;
+	f32 dsp_frequency = 1.f;
 	switch (ansnd_output_samplerate) {
 	case ANSND_OUTPUT_SAMPLERATE_32KHZ:
-		microseconds_per_cycle = 7500.f;
+		dsp_frequency = ANSND_DSP_FREQ_32KHZ;
 		break;
 	case ANSND_OUTPUT_SAMPLERATE_48KHZ:
-		microseconds_per_cycle = 5000.f;
+		dsp_frequency = ANSND_DSP_FREQ_48KHZ;
 		break;
 #if defined(HW_DOL)
 	case ANSND_OUTPUT_SAMPLERATE_96KHZ:
-		microseconds_per_cycle = 2500.f;
+		dsp_frequency = ANSND_DSP_FREQ_96KHZ;
 		break;
 #endif
 	default:
 		break;
 	}
 	
+	f32 release_coefficient = 0.f;
+	if (release_time != 0) {
+		release_coefficient = expf(-1000000.f / (release_time * dsp_frequency));
+	}
+	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	*total_usage = ticks_to_microsecs(ansnd_total_process_time) / microseconds_per_cycle;
+	// start from silence and unity gain whenever the limiter is switched on
+	if (enabled && !ansnd_limiter.enabled) {
+		memset(&ansnd_limiter, 0, sizeof(ansnd_limiter_t));
+		for (u32 i = 0; i < LIMITER_LOOKAHEAD; ++i) {
+			ansnd_limiter.smoothing_window[i] = 1.f;
+		}
+		ansnd_limiter.release_gain = 1.f;
+	}
+	
+	ansnd_limiter.enabled             = enabled;
+	ansnd_limiter.input_gain          = input_gain;
+	ansnd_limiter.threshold           = threshold * 32767.f;
+	ansnd_limiter.release_coefficient = release_coefficient;
+	if (!enabled) {
+		ansnd_limiter.gain_reduction = 0.f;
+	}
 	
 	_CPU_ISR_Restore(level);
 	
 	return ANSND_ERROR_OK;
 }
 
-s32 ansnd_get_total_active_voices(u32* active_voices) {
+s32 ansnd_get_limiter_gain_reduction(f32* gain_reduction) {
 	if (!ansnd_library_initialized) {
 		return ANSND_ERROR_NOT_INITIALIZED;
 	}
-	if (!active_voices) {
+	if (!gain_reduction) {
 		return ANSND_ERROR_OK;
 	}
 	
 	u32 level;
 	_CPU_ISR_Disable(level);
 	
-	*active_voices = ansnd_active_voices;
+	*gain_reduction = ansnd_limiter.gain_reduction;
 	
 	_CPU_ISR_Restore(level);
 	
@@ -1602,3 +4346,19 @@ s32 ansnd_register_audio_callback(ansnd_audio_callback_t callback, void* callbac
 	
 	return ANSND_ERROR_OK;
 }
+
+s32 ansnd_register_aux_callback(u8 aux_bus, ansnd_aux_callback_t callback, void* callback_arguments) {
+	if (aux_bus >= ANSND_MAX_AUX_BUSES) {
+		return ANSND_ERROR_INVALID_INPUT;
+	}
+	
+	u32 level;
+	_CPU_ISR_Disable(level);
+	
+	ansnd_aux_callbacks[aux_bus] = callback;
+	ansnd_aux_callback_arguments[aux_bus] = callback_arguments;
+	
+	_CPU_ISR_Restore(level);
+	
+	return ANSND_ERROR_OK;
+}
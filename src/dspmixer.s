@@ -82,7 +82,6 @@ CMD_VOICE:             equ 0xFACE // Identifier for voice commands
 CMD_VOICE_END:         equ 0xDEAD // Voice command terminate task
 CMD_VOICE_NEXT:        equ 0x1111 // Voice command process next set of data
 CMD_VOICE_PREPARE:     equ 0x2222 // Voice command prepare for next cycle
-CMD_VOICE_MM_LOCATION: equ 0x3333 // Voice command receive main memory base locations
 CMD_VOICE_RESTART:     equ 0x4444 // Voice command restart dsp processing cycle
 
 // Accelerator formats
@@ -107,20 +106,74 @@ VOICE_FLAG_LOOPED:     equ 0x0004
 VOICE_FLAG_ADPCM:      equ 0x0002
 VOICE_FLAG_STEREO:     equ 0x0001
 
+// Mix group flags
+GROUP_FLAG_PAUSED:     equ 0x0001
+
+// Mix flags
+MIX_FLAG_WIDE:         equ 0x0001 // voices accumulate into the 32-bit mix buffer
+MIX_FLAG_MASTER_GAIN:  equ 0x0002 // the wide mix is scaled by the master gain
+
+// Envelope states
+ENVELOPE_STATE_OFF:     equ 0x0000
+ENVELOPE_STATE_ATTACK:  equ 0x0001
+ENVELOPE_STATE_DECAY:   equ 0x0002
+ENVELOPE_STATE_SUSTAIN: equ 0x0003
+ENVELOPE_STATE_RELEASE: equ 0x0004
+
+// LFO shapes
+LFO_SHAPE_OFF:          equ 0x0000
+LFO_SHAPE_SINE:         equ 0x0001
+LFO_SHAPE_TRIANGLE:     equ 0x0002
+LFO_SHAPE_SQUARE:       equ 0x0003
+
+// Glide modes
+GLIDE_MODE_LINEAR:      equ 0x0000
+GLIDE_MODE_EXPONENTIAL: equ 0x0001
+
+// Resample qualities, sinc and cubic both go through resample or resample_table
+RESAMPLE_QUALITY_SINC:    equ 0x0000
+RESAMPLE_QUALITY_NEAREST: equ 0x0001
+RESAMPLE_QUALITY_LINEAR:  equ 0x0002
+RESAMPLE_QUALITY_CUBIC:   equ 0x0003
+
 // Memory defines
 MAX_PARAMETER_BLOCKS:        equ 48
+MAX_AUX_BUSES:               equ 2
+MAX_GROUPS:                  equ 8
 NUMBER_SAMPLES:              equ 240
 SOUND_BUFFER_SIZE:           equ 960  // size in bytes
-PARAMETER_BLOCK_STRUCT_SIZE: equ 128  // size in bytes
-WORKING_MEMORY_SIZE:         equ 64   // size in words
+COMMAND_BLOCK_SIZE:          equ 192  // size in bytes
+MIX_TABLE_SIZE:              equ 64   // size in bytes
+COMMAND_BLOCK_VERSION:       equ 0x0002
+RESAMPLE_TABLE_SIZE:         equ 2048 // largest size in bytes
+PARAMETER_BLOCK_STRUCT_SIZE: equ 256  // size in bytes
+WORKING_MEMORY_SIZE:         equ 128  // size in words
 DATA_RAM_SIZE:               equ 4096 // size in words
 
-PB_ARRAY_BASE:               equ 0x0000
-PB_ARRAY_END:                equ PB_ARRAY_BASE + (PARAMETER_BLOCK_STRUCT_SIZE / 2) * MAX_PARAMETER_BLOCKS
-SOUND_BUFFER_BASE:           equ PB_ARRAY_END
+// parameter blocks live in main memory and are processed one at a time in this buffer
+PB_BUFFER_BASE:              equ 0x0000
+PB_BUFFER_END:               equ PB_BUFFER_BASE + (PARAMETER_BLOCK_STRUCT_SIZE / 2)
+SOUND_BUFFER_BASE:           equ PB_BUFFER_END
 SOUND_BUFFER_END:            equ SOUND_BUFFER_BASE + (SOUND_BUFFER_SIZE / 2)
 WORKING_MEMORY_BASE:         equ SOUND_BUFFER_END
 WORKING_MEMORY_END:          equ WORKING_MEMORY_BASE + WORKING_MEMORY_SIZE
+// aux buses have the same layout as the sound buffer and are stored back to back
+AUX_BUFFER_BASE:             equ WORKING_MEMORY_END
+AUX_BUFFER_END:              equ AUX_BUFFER_BASE + ((SOUND_BUFFER_SIZE / 2) * MAX_AUX_BUSES)
+// wide mix, two words per sample, right is high then low, left is low then high
+MIX_BUFFER_BASE:             equ AUX_BUFFER_END
+MIX_BUFFER_END:              equ MIX_BUFFER_BASE + SOUND_BUFFER_SIZE
+
+COMMAND_BLOCK_BASE:          equ MIX_BUFFER_END
+COMMAND_BLOCK_END:           equ COMMAND_BLOCK_BASE + (COMMAND_BLOCK_SIZE / 2)
+
+// the next parameter block is fetched into the other buffer while the current one is mixed
+PB_BUFFER_2_BASE:            equ COMMAND_BLOCK_END
+PB_BUFFER_2_END:             equ PB_BUFFER_2_BASE + (PARAMETER_BLOCK_STRUCT_SIZE / 2)
+
+// resampling coefficients of the current voice, one row per phase with the error factor after the coefficients
+RESAMPLE_TABLE_BASE:         equ PB_BUFFER_2_END
+RESAMPLE_TABLE_END:          equ RESAMPLE_TABLE_BASE + (RESAMPLE_TABLE_SIZE / 2)
 
 // --- Parameter block offets --- //
 
@@ -173,6 +226,75 @@ PB_NEXT_PDS:          equ 0x3D
 PB_NEXT_YN1:          equ 0x3E
 PB_NEXT_YN2:          equ 0x3F
 
+// volume ramping
+PB_VOL_RAMP_CYCLES:   equ 0x40
+PB_R_VOL_LO:          equ 0x41
+PB_R_VOL_DELTA_HI:    equ 0x42
+PB_R_VOL_DELTA_LO:    equ 0x43
+PB_L_VOL_LO:          equ 0x44
+PB_L_VOL_DELTA_HI:    equ 0x45
+PB_L_VOL_DELTA_LO:    equ 0x46
+PB_R_VOL_TARGET:      equ 0x47
+PB_L_VOL_TARGET:      equ 0x48
+
+// envelope
+PB_ENV_STATE:         equ 0x49
+PB_ENV_LEVEL_HI:      equ 0x4A
+PB_ENV_LEVEL_LO:      equ 0x4B
+PB_ENV_ATTACK_HI:     equ 0x4C
+PB_ENV_ATTACK_LO:     equ 0x4D
+PB_ENV_DECAY_HI:      equ 0x4E
+PB_ENV_DECAY_LO:      equ 0x4F
+PB_ENV_SUSTAIN:       equ 0x50
+PB_ENV_RELEASE_HI:    equ 0x51
+PB_ENV_RELEASE_LO:    equ 0x52
+
+// gain applied on top of the volume
+PB_GAIN:              equ 0x53
+
+// lfo
+PB_LFO_SHAPE:         equ 0x54
+PB_LFO_PHASE:         equ 0x55
+PB_LFO_PHASE_STEP:    equ 0x56
+PB_LFO_PITCH_DEPTH:   equ 0x57
+PB_LFO_VOLUME_DEPTH:  equ 0x58
+
+// pitch glide
+PB_GLIDE_CYCLES:      equ 0x59
+PB_GLIDE_MODE:        equ 0x5A
+PB_GLIDE_DELTA_HI:    equ 0x5B
+PB_GLIDE_DELTA_LO:    equ 0x5C
+PB_GLIDE_TARGET_HI:   equ 0x5D
+PB_GLIDE_TARGET_LO:   equ 0x5E
+
+// biquad filter, 32-bit b0, b1, b2, a1, a2 shared by both channels, then the s1, s2 state of each channel
+PB_BIQUAD_TYPE:       equ 0x5F
+PB_BIQUAD_COEFS:      equ 0x60
+PB_BIQUAD_R:          equ 0x6A
+PB_BIQUAD_L:          equ 0x6E
+
+// aux bus send levels
+PB_AUX_A_SEND:        equ 0x72
+PB_AUX_B_SEND:        equ 0x73
+
+// mix group index
+PB_GROUP:             equ 0x74
+
+// metering, the peak and power are measured over each cycle
+PB_METER:             equ 0x75
+PB_METER_PEAK:        equ 0x76
+PB_METER_POWER_HI:    equ 0x77
+PB_METER_POWER_LO:    equ 0x78
+PB_METER_SAMPLES:     equ 0x79
+
+// coefficient table built by the CPU, used instead of the coefficient ROM when the mask is set
+PB_RESAMPLE_TABLE_MASK: equ 0x7A
+PB_RESAMPLE_TABLE_HI:   equ 0x7B
+PB_RESAMPLE_TABLE_LO:   equ 0x7C
+
+// interpolation used when resampling
+PB_RESAMPLE_QUALITY:    equ 0x7D
+
 // --- Working memory addresses --- //
 
 WORK_MMEM_PB_ARRAY_BASE_HI:   equ WORKING_MEMORY_BASE + 0x00
@@ -207,8 +329,93 @@ WORK_RESAMPLING_COEF_BUF:     equ WORKING_MEMORY_BASE + 0x17
 WORK_COEF_PAD_2:              equ WORKING_MEMORY_BASE + 0x27
 WORK_ERROR_FACTOR:            equ WORKING_MEMORY_BASE + 0x28
 
+WORK_CURR_PB_INDEX:           equ WORKING_MEMORY_BASE + 0x29
+WORK_SAMPLE_FUNCTION:         equ WORKING_MEMORY_BASE + 0x2A
+WORK_RAMP_NEXT_FUNCTION:      equ WORKING_MEMORY_BASE + 0x2B
+WORK_MIX_VOLUME:              equ WORKING_MEMORY_BASE + 0x2C
+WORK_METER_ADDR:              equ WORKING_MEMORY_BASE + 0x2D
+WORK_METER_NEXT_FUNCTION:     equ WORKING_MEMORY_BASE + 0x2E
+
 WORK_PCM_ACC_COEF:            equ WORKING_MEMORY_BASE + 0x30
 
+WORK_R_VOL_LO:                equ WORKING_MEMORY_BASE + 0x40
+WORK_R_VOL_DELTA_HI:          equ WORKING_MEMORY_BASE + 0x41
+WORK_R_VOL_DELTA_LO:          equ WORKING_MEMORY_BASE + 0x42
+WORK_L_VOL_LO:                equ WORKING_MEMORY_BASE + 0x43
+WORK_L_VOL_DELTA_HI:          equ WORKING_MEMORY_BASE + 0x44
+WORK_L_VOL_DELTA_LO:          equ WORKING_MEMORY_BASE + 0x45
+
+WORK_GAIN_HI:                 equ WORKING_MEMORY_BASE + 0x46
+WORK_GAIN_LO:                 equ WORKING_MEMORY_BASE + 0x47
+WORK_GAIN_DELTA_HI:           equ WORKING_MEMORY_BASE + 0x48
+WORK_GAIN_DELTA_LO:           equ WORKING_MEMORY_BASE + 0x49
+WORK_R_GAIN_VOL:              equ WORKING_MEMORY_BASE + 0x4A
+WORK_L_GAIN_VOL:              equ WORKING_MEMORY_BASE + 0x4B
+
+WORK_LFO_VALUE:               equ WORKING_MEMORY_BASE + 0x4C
+WORK_LFO_GAIN:                equ WORKING_MEMORY_BASE + 0x4D
+
+WORK_BIQUAD_R_ADDR:           equ WORKING_MEMORY_BASE + 0x4E
+WORK_BIQUAD_L_ADDR:           equ WORKING_MEMORY_BASE + 0x4F
+WORK_BIQUAD_SAMPLE:           equ WORKING_MEMORY_BASE + 0x50
+WORK_BIQUAD_NEXT_FUNCTION:    equ WORKING_MEMORY_BASE + 0x51
+WORK_BIQUAD_Y_LO:             equ WORKING_MEMORY_BASE + 0x2F
+
+WORK_AUX_A_SEND:              equ WORKING_MEMORY_BASE + 0x52
+WORK_AUX_B_SEND:              equ WORKING_MEMORY_BASE + 0x53
+WORK_AUX_R_SAMPLE:            equ WORKING_MEMORY_BASE + 0x54
+WORK_AUX_L_SAMPLE:            equ WORKING_MEMORY_BASE + 0x55
+WORK_AUX_R_PART:              equ WORKING_MEMORY_BASE + 0x56
+WORK_AUX_L_PART:              equ WORKING_MEMORY_BASE + 0x57
+WORK_MMEM_AUX_BUF_BASE_HI:    equ WORKING_MEMORY_BASE + 0x58
+WORK_MMEM_AUX_BUF_BASE_LO:    equ WORKING_MEMORY_BASE + 0x59
+
+WORK_MMEM_COMMAND_BLOCK_HI:   equ WORKING_MEMORY_BASE + 0x5A
+WORK_MMEM_COMMAND_BLOCK_LO:   equ WORKING_MEMORY_BASE + 0x5B
+WORK_GROUP_VOLUME:            equ WORKING_MEMORY_BASE + 0x5C
+WORK_AUX_ADDR:                equ WORKING_MEMORY_BASE + 0x5D
+WORK_AUX_NEXT_FUNCTION:       equ WORKING_MEMORY_BASE + 0x5E
+WORK_VOICE_LIST_INDEX:        equ WORKING_MEMORY_BASE + 0x5F
+
+// Command block, fetched from main memory once per cycle
+
+CB_VERSION:                   equ COMMAND_BLOCK_BASE + 0x00
+CB_VOICE_COUNT:               equ COMMAND_BLOCK_BASE + 0x01
+CB_MMEM_PB_ARRAY_BASE_HI:     equ COMMAND_BLOCK_BASE + 0x02 // the main memory locations are only taken at init
+CB_MMEM_AUX_BUF_BASE_HI:      equ COMMAND_BLOCK_BASE + 0x08
+CB_RESAMPLE_TABLE_SIZE:       equ COMMAND_BLOCK_BASE + 0x0A // in bytes, the same for every voice
+CB_RESAMPLE_TABLE_SHIFT:      equ COMMAND_BLOCK_BASE + 0x0B // minus the log2 of the table size in words
+
+// volume and flags of each mix group followed by the master settings
+CB_GROUP_TABLE:               equ COMMAND_BLOCK_BASE + 0x10
+CB_MASTER_GAIN:               equ CB_GROUP_TABLE + (MAX_GROUPS * 2)
+CB_MIX_FLAGS:                 equ CB_GROUP_TABLE + (MAX_GROUPS * 2) + 1
+
+// indices of the parameter blocks to mix this cycle
+CB_VOICE_LIST:                equ COMMAND_BLOCK_BASE + 0x30
+
+WORK_NEXT_PB_ADDR:            equ WORKING_MEMORY_BASE + 0x60
+WORK_NEXT_PB_INDEX:           equ WORKING_MEMORY_BASE + 0x61
+WORK_RESAMPLE_TABLE_MASK:     equ WORKING_MEMORY_BASE + 0x62
+WORK_HALF_STEP_COEFS:         equ WORKING_MEMORY_BASE + 0x62 // shared, half steps never run from a table
+
+// coefficients for the phase with the top bit of the fraction clear, for exact ratios
+WORK_RESAMPLING_COEF_BUF_2:   equ WORKING_MEMORY_BASE + 0x63 // 17 words
+
+// biquad coefficients of the current voice, each a signed high half and the low half shifted right by 1
+WORK_BIQUAD_B0_HI:            equ WORKING_MEMORY_BASE + 0x74
+WORK_BIQUAD_B0_LO:            equ WORKING_MEMORY_BASE + 0x75
+WORK_BIQUAD_B1_HI:            equ WORKING_MEMORY_BASE + 0x76
+WORK_BIQUAD_B1_LO:            equ WORKING_MEMORY_BASE + 0x77
+WORK_BIQUAD_B2_HI:            equ WORKING_MEMORY_BASE + 0x78
+WORK_BIQUAD_B2_LO:            equ WORKING_MEMORY_BASE + 0x79
+WORK_BIQUAD_A1_HI:            equ WORKING_MEMORY_BASE + 0x7A
+WORK_BIQUAD_A1_LO:            equ WORKING_MEMORY_BASE + 0x7B
+WORK_BIQUAD_A2_HI:            equ WORKING_MEMORY_BASE + 0x7C
+WORK_BIQUAD_A2_LO:            equ WORKING_MEMORY_BASE + 0x7D
+WORK_BIQUAD_X:                equ WORKING_MEMORY_BASE + 0x7E
+WORK_BIQUAD_Y_HI:             equ WORKING_MEMORY_BASE + 0x7F
+
 // --- Code --- //
 
 _start:
@@ -226,11 +433,13 @@ _start:
 init:
 	lris      $acc0.m, #CMD_SYSTEM_OUT_INIT
 	call      send_system_command
-	jmp       setup
+	jmp       init_task // keeps resume at its fixed entry vector
 	
 resume:
 	lris      $acc0.m, #CMD_SYSTEM_OUT_RESUME
 	call      send_system_command
+	call      setup
+	jmp       wait_command
 	
 setup:
 	// configure settings
@@ -253,6 +462,12 @@ setup:
 	mrr       $wr3,    $wr0
 	
 	lri       $acx0.h, #(32768 / 2) // constant used in resampling
+	ret
+
+// the only mail after init is the address of the main memory locations
+init_task:
+	call      setup
+	jmp       recv_mmem_base
 	
 wait_command:
 	clr       $acc0
@@ -278,9 +493,6 @@ wait_command:
 	cmpi      $acc1.m, #CMD_VOICE_RESTART
 	jeq       restart_processing
 	
-	cmpi      $acc1.m, #CMD_VOICE_MM_LOCATION
-	jeq       recv_mmem_base
-	
 	cmpi      $acc1.m, #CMD_VOICE_END
 	jeq       terminate_task
 	
@@ -292,24 +504,20 @@ process_voices:
 	s40
 	
 	call      send_audio_buffer
-	
-	si        @DMACR,  #(DMA_DMEM | DMA_TO_CPU)
-	call      init_pb_dma
-	call      dma_no_wait
-	
 	call      swap_audio_buffers
 	call      clear_audio_buffer
 	
-	call      wait_dma
-	
 	lris      $acc0.m, #CMD_SYSTEM_OUT_IRQ
 	call      send_system_command
 	jmp       wait_command
 
+// the CPU has synced every parameter block and the voice list by now, so the head of the next cycle
+// is fetched here instead of after the next command, the DRAM is kept if the task yields
 prepare_for_processing:
-	si        @DMACR,  #(DMA_DMEM | DMA_TO_DSP)
-	call      init_pb_dma
-	call      dma
+	s16
+	call      prefetch_cycle
+	call      wait_dma
+	s40
 	
 	lris      $acc0.m, #CMD_SYSTEM_OUT_YIELD
 	call      send_system_command
@@ -322,11 +530,51 @@ restart_processing:
 
 // clobbers everything
 mix_and_resample:
-	clr       $acc1
+	// a cycle that was not prepared, the first one or one after a restart, is fetched now
+	lr        $acc0.m, @CB_VERSION
+	cmpi      $acc0.m, #COMMAND_BLOCK_VERSION
+	jeq       mix_and_resample_prefetched
+	
+	call      prefetch_cycle
+	
+	// a block laid out for another version can't be read, so the cycle stays silent
+	lr        $acc0.m, @CB_VERSION
+	cmpi      $acc0.m, #COMMAND_BLOCK_VERSION
+	retne
+	jmp       loop_mix_and_resample
+mix_and_resample_prefetched:
+	call      load_mix_table
 loop_mix_and_resample:
-	cmpi      $acc1.m, #PB_ARRAY_END
-	retge
-	sr        @WORK_CURR_PB_ADDR, $acc1.m
+	clr       $acc1
+	lr        $acc1.m, @WORK_VOICE_LIST_INDEX
+	clr       $acc0
+	lr        $acc0.m, @CB_VOICE_COUNT
+	cmp
+	jle       mix_and_resample_end
+	
+	// the prefetched block becomes the current one and the next is fetched while it is mixed
+	call      wait_dma
+	lr        $acc0.m, @WORK_NEXT_PB_ADDR
+	sr        @WORK_CURR_PB_ADDR, $acc0.m
+	lr        $acc0.m, @WORK_NEXT_PB_INDEX
+	sr        @WORK_CURR_PB_INDEX, $acc0.m
+	addis     $acc1.m, #1
+	sr        @WORK_VOICE_LIST_INDEX, $acc1.m
+	call      prefetch_parameter_block
+	
+	// skip voices in a paused group and pick up the group volume
+	lri       $ix0,    #PB_GROUP
+	call      set_pb_address
+	clr       $acc0
+	lrr       $acc0.m, @$ar0
+	lsl       $acc0,   #1
+	addi      $acc0.m, #CB_GROUP_TABLE
+	mrr       $ar0,    $acc0.m
+	lrri      $acx1.h, @$ar0
+	sr        @WORK_GROUP_VOLUME, $acx1.h
+	lrr       $acc0.m, @$ar0
+	andf      $acc0.m, #GROUP_FLAG_PAUSED
+	jlnz      skip_pb
 	
 	lri       $ix0,    #PB_FLAGS
 	call      set_pb_address
@@ -341,19 +589,26 @@ loop_mix_and_resample:
 // v Core Loop v
 	lri       $wr0,    #0x01FC
 	bloop     $acc1.m, mixing_complete
-	lr        $ar0,    @WORK_RESAMPLE_FUNCTION
+	lr        $ar0,    @WORK_SAMPLE_FUNCTION
 	jmpr      $ar0
 core_loop_end:
 // ^ Core Loop ^
 	lri       $wr0,    #0xFFFF
 	call      uninit_parameter_block
 // ^ Parameter Block Section ^
+	call      store_parameter_block
 	
-	lr        $acc1.m, @WORK_CURR_PB_ADDR
 skip_pb:
-	addis     $acc1.m, #(PARAMETER_BLOCK_STRUCT_SIZE / 2)
 	jmp       loop_mix_and_resample
 
+mix_and_resample_end:
+	call      wait_dma // the last write-back
+	
+	// the next cycle has to be prepared again before its prefetch is trusted
+	clr       $acc0
+	sr        @CB_VERSION, $acc0.m
+	ret
+
 // mono
 //  next mono sample in $acc0
 // stereo
@@ -365,7 +620,7 @@ mix_mono:
 	mov       $acc1,   $acc0
 	clrp
 mix_stereo:
-	lri       $ar0,    #WORK_R_VOL
+	lr        $ar0,    @WORK_MIX_VOLUME
 	addp'l    $acc1                       : $acx1.h, @$ar0
 	mulc'l    $acc0.m, $acx1.h            : $acc0.m, @$ar3
 	lrr       $acx1.h, @$ar0
@@ -376,6 +631,247 @@ mixing_complete:
 	s16's                                 : @$ar3,   $acc1.m
 	jmp       core_loop_end
 
+// same inputs as mix_mono and mix_stereo, accumulates into the wide mix buffer instead
+// the sample is kept with 8 fractional bits, so the sum has 8 bits of headroom and never saturates
+// clobbers $acc0, $acc1, $acx1, $ar0
+mix_mono_wide:
+	mov       $acc1,   $acc0
+	clrp
+mix_stereo_wide:
+	lr        $ar0,    @WORK_MIX_VOLUME
+	addp'l    $acc1                       : $acx1.h, @$ar0
+	mulc'l    $acc0.m, $acx1.h            : $acx1.h, @$ar0
+	movp      $acc0
+	mulc      $acc1.m, $acx1.h
+	movp      $acc1
+	asr       $acc0,   #8
+	asr       $acc1,   #8
+	lrri      $acx1.h, @$ar3                                          // right high
+	lrrd      $acx1.l, @$ar3                                          // right low
+	addax     $acc0,   $acx1
+	srri      @$ar3,   $acc0.m
+	srri      @$ar3,   $acc0.l
+	lrri      $acx1.l, @$ar3                                          // left low
+	lrrd      $acx1.h, @$ar3                                          // left high
+	addax     $acc1,   $acx1
+	srri      @$ar3,   $acc1.l
+	jmp       mixing_complete                                         // stores left high
+
+// filters the resampled sample through the voice biquad, then sends or mixes it
+// clobbers $acc0, $acc1, $acx1, $ar0
+biquad_mono:
+	lr        $ar0,    @WORK_BIQUAD_R_ADDR
+	call      apply_biquad
+	lr        $ar0,    @WORK_BIQUAD_NEXT_FUNCTION
+	jmpr      $ar0
+biquad_stereo:
+	addp      $acc1                       // complete the left sample
+	sr        @WORK_BIQUAD_SAMPLE, $acc1.m
+	lr        $ar0,    @WORK_BIQUAD_R_ADDR
+	call      apply_biquad
+	lr        $acc1.m, @WORK_BIQUAD_SAMPLE
+	sr        @WORK_BIQUAD_SAMPLE, $acc0.m
+	mov       $acc0,   $acc1
+	lr        $ar0,    @WORK_BIQUAD_L_ADDR
+	call      apply_biquad
+	mov       $acc1,   $acc0
+	lr        $acc0.m, @WORK_BIQUAD_SAMPLE
+	clrp
+	lr        $ar0,    @WORK_BIQUAD_NEXT_FUNCTION
+	jmpr      $ar0
+
+// accumulates the sample into the aux buses by the voice's send levels, after its volume, then mixes
+// same inputs as mix_mono and mix_stereo
+// clobbers $acc0, $acc1, $acx1, $ar0, uses $ix2 to step between buffers
+aux_mono:
+	mov       $acc1,   $acc0
+	clrp
+aux_stereo:
+	addp      $acc1                       // complete the left sample
+	sr        @WORK_AUX_R_SAMPLE, $acc0.m
+	sr        @WORK_AUX_L_SAMPLE, $acc1.m
+	
+	// apply the current volumes once for all buses
+	lr        $ar0,    @WORK_MIX_VOLUME
+	lrri      $acx1.h, @$ar0
+	mulc      $acc0.m, $acx1.h
+	lrr       $acx1.h, @$ar0
+	movp      $acc0
+	mulc      $acc1.m, $acx1.h
+	movp      $acc1
+	sr        @WORK_AUX_R_PART, $acc0.m
+	sr        @WORK_AUX_L_PART, $acc1.m
+	
+	// the aux buffers cross wrapping boundaries of $wr0, address them through $ar3 instead
+	mrr       $st1,    $ar3
+	lr        $ar3,    @WORK_AUX_ADDR
+	
+	lr        $acx1.h, @WORK_AUX_A_SEND
+	lr        $acx1.l, @WORK_AUX_R_PART
+	mul       $acx1.l, $acx1.h
+	lr        $acx1.l, @WORK_AUX_L_PART
+	lrr       $acc0.m, @$ar3
+	addp      $acc0
+	mul       $acx1.l, $acx1.h
+	srri      @$ar3,   $acc0.m
+	lrr       $acc1.m, @$ar3
+	addp      $acc1
+	srri      @$ar3,   $acc1.m
+	
+	sr        @WORK_AUX_ADDR, $ar3
+	addarn    $ar3,    $ix2
+	
+	lr        $acx1.h, @WORK_AUX_B_SEND
+	lr        $acx1.l, @WORK_AUX_R_PART
+	mul       $acx1.l, $acx1.h
+	lr        $acx1.l, @WORK_AUX_L_PART
+	lrr       $acc0.m, @$ar3
+	addp      $acc0
+	mul       $acx1.l, $acx1.h
+	srri      @$ar3,   $acc0.m
+	lrr       $acc1.m, @$ar3
+	addp      $acc1
+	srri      @$ar3,   $acc1.m
+	
+	mrr       $ar3,    $st1
+	
+	lr        $acc0.m, @WORK_AUX_R_SAMPLE
+	lr        $acc1.m, @WORK_AUX_L_SAMPLE
+	clrp
+	lr        $ar0,    @WORK_AUX_NEXT_FUNCTION
+	jmpr      $ar0
+
+// measures the peak and power of the sample before the voice volume, then sends or mixes it
+// same inputs as mix_mono and mix_stereo, the power is the sum of both channels squared, divided by 256
+// clobbers $acc0, $acc1, $acx1, $ar0
+meter_mono:
+	mov       $acc1,   $acc0
+	clrp
+meter_stereo:
+	addp      $acc1                       // complete the left sample
+	mrr       $acx1.h, $acc0.m
+	mrr       $acx1.l, $acc0.m                                        // keep right
+	mulc      $acc0.m, $acx1.h
+	mrr       $acx1.h, $acc1.m                                        // keep left
+	lr        $ar0,    @WORK_METER_ADDR
+	movp      $acc0
+	mulc      $acc1.m, $acx1.h
+	addp      $acc0
+	asr       $acc0,   #9                                             // undo the doubled products as well
+	iar       $ar0
+	lrri      $acc1.m, @$ar0                                          // power high
+	lrrd      $acc1.l, @$ar0                                          // power low
+	add       $acc1,   $acc0
+	srri      @$ar0,   $acc1.m
+	srr       @$ar0,   $acc1.l
+	
+	mrr       $acc0.m, $acx1.l
+	abs       $acc0
+	mrr       $acc1.m, $acx1.h
+	abs       $acc1
+	cmp       $acc0,   $acc1
+	jge       meter_peak
+	mov       $acc0,   $acc1
+meter_peak:
+	lr        $ar0,    @WORK_METER_ADDR
+	lrr       $acc1.m, @$ar0
+	cmp       $acc0,   $acc1
+	jle       meter_end
+	srr       @$ar0,   $acc0.m
+meter_end:
+	mrr       $acc0.m, $acx1.l
+	mrr       $acc1.m, $acx1.h
+	clrp
+	lr        $ar0,    @WORK_METER_NEXT_FUNCTION
+	jmpr      $ar0
+
+// filters the sample in $acc0.m with the state at $ar0 and returns it in $acc0, as a transposed direct form II
+// coefficients are signed 2.30 fixed point, with a1 and a2 negated, and the state is kept to 16 fractional bits
+// so low cutoffs keep their precision and the feedback doesn't amplify rounding of the output
+// each product is the high halves plus the cross terms with the low halves, which are summed apart and scaled down
+// y is clipped in s40, only the state arithmetic runs in s16 and wraps
+// clobbers $acc0, $acc1, $acx1, $ar0
+apply_biquad:
+	sr        @WORK_BIQUAD_X, $acc0.m
+	
+	// y = b0 * x + s1
+	lr        $acx1.l, @WORK_BIQUAD_X
+	lr        $acx1.h, @WORK_BIQUAD_B0_HI
+	mul       $acx1.l, $acx1.h
+	clr       $acc1
+	lr        $acx1.h, @WORK_BIQUAD_B0_LO
+	mulac     $acx1.l, $acx1.h, $acc1
+	clr       $acc0
+	lri       $acc0.l, #0x4000 // rounds the low halves
+	addp      $acc0
+	asr       $acc0,   #15
+	add       $acc1,   $acc0
+	asl       $acc1,   #1
+	lrri      $acc0.m, @$ar0                                          // s1 high, sign extended
+	lrri      $acc0.l, @$ar0                                          // s1 low
+	add       $acc0,   $acc1
+	sr        @WORK_BIQUAD_Y_HI, $acc0.m                              // saturated
+	clr       $acc1
+	mrr       $acc1.l, $acc0.l
+	lsr       $acc1,   #1
+	sr        @WORK_BIQUAD_Y_LO, $acc1.l
+	s16
+	
+	// s1 = b1 * x + a1 * y + s2
+	clr       $acc0
+	clr       $acc1
+	lri       $acc0.l, #0x4000
+	lr        $acx1.l, @WORK_BIQUAD_X
+	lr        $acx1.h, @WORK_BIQUAD_B1_HI
+	mul       $acx1.l, $acx1.h
+	lr        $acx1.h, @WORK_BIQUAD_B1_LO
+	mulac     $acx1.l, $acx1.h, $acc1
+	lr        $acx1.l, @WORK_BIQUAD_Y_HI
+	lr        $acx1.h, @WORK_BIQUAD_A1_LO
+	mulac     $acx1.l, $acx1.h, $acc0
+	lr        $acx1.h, @WORK_BIQUAD_A1_HI
+	mulac     $acx1.l, $acx1.h, $acc0
+	lr        $acx1.l, @WORK_BIQUAD_Y_LO
+	mulac     $acx1.l, $acx1.h, $acc1
+	addp      $acc0
+	asr       $acc0,   #15
+	add       $acc1,   $acc0
+	asl       $acc1,   #1
+	lrri      $acc0.m, @$ar0                                          // s2 high
+	lrrd      $acc0.l, @$ar0                                          // s2 low
+	add       $acc1,   $acc0
+	dar       $ar0
+	dar       $ar0
+	srri      @$ar0,   $acc1.m                                        // s1 high
+	srri      @$ar0,   $acc1.l                                        // s1 low
+	
+	// s2 = b2 * x + a2 * y
+	clr       $acc0
+	clr       $acc1
+	lri       $acc0.l, #0x4000
+	lr        $acx1.l, @WORK_BIQUAD_X
+	lr        $acx1.h, @WORK_BIQUAD_B2_HI
+	mul       $acx1.l, $acx1.h
+	lr        $acx1.h, @WORK_BIQUAD_B2_LO
+	mulac     $acx1.l, $acx1.h, $acc1
+	lr        $acx1.l, @WORK_BIQUAD_Y_HI
+	lr        $acx1.h, @WORK_BIQUAD_A2_LO
+	mulac     $acx1.l, $acx1.h, $acc0
+	lr        $acx1.h, @WORK_BIQUAD_A2_HI
+	mulac     $acx1.l, $acx1.h, $acc0
+	lr        $acx1.l, @WORK_BIQUAD_Y_LO
+	mulac     $acx1.l, $acx1.h, $acc1
+	addp      $acc0
+	asr       $acc0,   #15
+	add       $acc1,   $acc0
+	asl       $acc1,   #1
+	srri      @$ar0,   $acc1.m                                        // s2 high
+	srri      @$ar0,   $acc1.l                                        // s2 low
+	
+	s40
+	lr        $acc0.m, @WORK_BIQUAD_Y_HI                              // sign extended, with the low part cleared
+	ret
+
 // clobbers $acc1.m
 next_sample_stereo:
 	lrs       $acc1.m, @ACDAT
@@ -386,6 +882,54 @@ next_sample_complete:
 	srri      @$ar1,   $acc1.m
 	jmpr      $ar3
 
+// steps both volumes by their deltas once per output sample, then resamples
+// clobbers $acc0, $acc1, $acx1, $ar0
+ramp_volume:
+	lri       $ar0,    #WORK_R_VOL_LO
+	lr        $acx1.h, @WORK_R_VOL
+	lrri      $acx1.l, @$ar0                                          // right volume low
+	movax'l   $acc0,   $acx1              : $acx1.h, @$ar0            // right delta high
+	lrri      $acx1.l, @$ar0                                          // right delta low
+	addax     $acc0,   $acx1
+	lr        $acx1.h, @WORK_L_VOL
+	lrri      $acx1.l, @$ar0                                          // left volume low
+	movax'l   $acc1,   $acx1              : $acx1.h, @$ar0            // left delta high
+	lrri      $acx1.l, @$ar0                                          // left delta low
+	addax     $acc1,   $acx1
+	
+	sr        @WORK_R_VOL,    $acc0.m
+	sr        @WORK_R_VOL_LO, $acc0.l
+	sr        @WORK_L_VOL,    $acc1.m
+	sr        @WORK_L_VOL_LO, $acc1.l
+	
+	lr        $ar0,    @WORK_RAMP_NEXT_FUNCTION
+	jmpr      $ar0
+
+// steps the envelope and lfo gain once per output sample and scales both volumes by it, then resamples
+// clobbers $acc0, $acc1, $acx1, $ar0
+apply_gain:
+	lri       $ar0,    #WORK_GAIN_HI
+	lrri      $acx1.h, @$ar0
+	lrri      $acx1.l, @$ar0
+	movax'l   $acc0,   $acx1              : $acx1.h, @$ar0            // gain delta high
+	lrri      $acx1.l, @$ar0                                          // gain delta low
+	addax     $acc0,   $acx1
+	
+	sr        @WORK_GAIN_HI, $acc0.m
+	sr        @WORK_GAIN_LO, $acc0.l
+	
+	lr        $acx1.h, @WORK_R_VOL
+	mulc      $acc0.m, $acx1.h
+	lr        $acx1.h, @WORK_L_VOL
+	movp      $acc1
+	mulc      $acc0.m, $acx1.h
+	sr        @WORK_R_GAIN_VOL, $acc1.m
+	movp      $acc1
+	sr        @WORK_L_GAIN_VOL, $acc1.m
+	
+	lr        $ar0,    @WORK_RESAMPLE_FUNCTION
+	jmpr      $ar0
+
 // clobbers $acc0, $acc1, $ar0
 resample_no_resample:
 	mrr       $st1,    $ar3
@@ -457,7 +1001,7 @@ resample_coefficients_loop_end:
 	
 // v Calculate New Samples v
 	lri       $ar3,    #WORK_RESAMPLING_COEF_BUF
-	
+resample_samples: // $ar3 points at the coefficients followed by a pad word and the error factor
 	clrp
 	// partially unroll the loop to reduce instructions inside
 	clr'ldax  $acc1                                  : $acx1,   @$ar1
@@ -476,6 +1020,218 @@ resample_end:
 	lr        $ar0,    @WORK_MIX_FUNCTION
 	jmpr      $ar0
 
+// holds the newest sample read, for voices that don't need interpolation
+// clobbers $acc0, $acc1, $ar0
+resample_nearest:
+	mrr       $st1,    $ar3
+	
+// v Adjust Relative Frequency Offsets v
+	lri       $ar3,    #WORK_REL_FREQ_HI
+	clr'l     $acc0                       : $acx1.h, @$ar3
+	clr'l     $acc1                       : $acx1.l, @$ar3
+	lrr       $acc0.l, @$ar3
+	addax     $acc0,   $acx1
+	srr       @$ar3,   $acc0.l
+// ^ Adjust Relative Frequency Offsets ^
+	
+// v Read Samples Loop v
+	lr        $ar0,    @WORK_NEXT_SAMPLE_FUNCTION
+	lri       $ar3,    #resample_nearest_read_loop_end
+	bloop     $acc0.m, next_sample_complete
+	jmpr      $ar0
+resample_nearest_read_loop_end:
+// ^ Read Samples Loop ^
+	
+	jmp       resample_no_resample_read_end
+
+// interpolates between the two newest samples read by the fraction of the relative frequency offset
+// clobbers $acc0, $acc1, $acx1, $ar0
+resample_linear:
+	mrr       $st1,    $ar3
+	
+// v Adjust Relative Frequency Offsets v
+	lri       $ar3,    #WORK_REL_FREQ_HI
+	clr'l     $acc0                       : $acx1.h, @$ar3
+	clr'l     $acc1                       : $acx1.l, @$ar3
+	lrr       $acc0.l, @$ar3
+	addax     $acc0,   $acx1
+	srr       @$ar3,   $acc0.l
+// ^ Adjust Relative Frequency Offsets ^
+	
+// v Read Samples Loop v
+	lr        $ar0,    @WORK_NEXT_SAMPLE_FUNCTION
+	lri       $ar3,    #resample_linear_read_loop_end
+	bloop     $acc0.m, next_sample_complete
+	jmpr      $ar0
+resample_linear_read_loop_end:
+// ^ Read Samples Loop ^
+	
+// v Interpolate Samples v
+	// samples are loaded sign extended into cleared accumulators
+	s40
+	
+	// fraction as a positive 1.15 value
+	clr       $acc1
+	mrr       $acc1.l, $acc0.l
+	lsl       $acc1,   #15
+	mrr       $acx1.h, $acc1.m
+	
+	// $ar1 and $ar2 point just past the newest sample, the difference is halved to fit the multiplier
+	dar       $ar1
+	dar       $ar1
+	lrri      $acc0.m, @$ar1
+	lrri      $acc1.m, @$ar1
+	sub       $acc1,   $acc0
+	asr       $acc1,   #1
+	mulc      $acc1.m, $acx1.h
+	movp      $acc1
+	asl       $acc1,   #1
+	add       $acc0,   $acc1
+	
+	dar       $ar2
+	dar       $ar2
+	lrri      $acx1.l, @$ar2
+	lrri      $acc1.m, @$ar2
+	subr      $acc1.m, $acx1.l
+	asr       $acc1,   #1
+	mulc      $acc1.m, $acx1.h
+	movp      $acc1
+	asl       $acc1,   #1
+	addr      $acc1.m, $acx1.l
+	clrp
+// ^ Interpolate Samples ^
+	jmp       resample_end
+
+// same as resample, but takes the coefficients and error factor for the phase from the table of the voice
+// clobbers everything
+resample_table:
+	mrr       $st1,    $ar3
+	
+// v Adjust Relative Frequency Offsets v
+	lri       $ar3,    #WORK_REL_FREQ_HI
+	clr'l     $acc0                       : $acx1.h, @$ar3
+	clr'l     $acc1                       : $acx1.l, @$ar3
+	lrr       $acc0.l, @$ar3
+	addax     $acc0,   $acx1
+	srr       @$ar3,   $acc0.l
+// ^ Adjust Relative Frequency Offsets ^
+	
+// v Read Samples Loop v
+	lr        $ar0,    @WORK_NEXT_SAMPLE_FUNCTION
+	lri       $ar3,    #resample_table_read_loop_end
+	bloop     $acc0.m, next_sample_complete
+	jmpr      $ar0
+resample_table_read_loop_end:
+// ^ Read Samples Loop ^
+	
+// v Select Coefficients v
+	// the table always spans the full fraction, shifted up to its size, the mask drops the bits below the row
+	mrr       $acx1.l, $acc0.l
+	clr       $acc0
+	mrr       $acc0.l, $acx1.l
+	lr        $acc1.m, @CB_RESAMPLE_TABLE_SHIFT
+	lsrn
+	lr        $acx1.h, @WORK_RESAMPLE_TABLE_MASK
+	andr      $acc0.m, $acx1.h
+	addi      $acc0.m, #RESAMPLE_TABLE_BASE
+	mrr       $ar3,    $acc0.m
+// ^ Select Coefficients ^
+	s40
+	clr       $acc0
+	jmp       resample_samples
+
+// half step ratios such as 1:2 alternate between two phases, told apart by the top bit of the fraction
+// their coefficients are calculated once per cycle by init_parameter_block, so the buffers are swapped instead of selected
+// clobbers everything
+resample_half_step:
+	mrr       $st1,    $ar3
+	
+// v Adjust Relative Frequency Offsets v
+	lri       $ar3,    #WORK_REL_FREQ_HI
+	clr'l     $acc0                       : $acx1.h, @$ar3
+	clr'l     $acc1                       : $acx1.l, @$ar3
+	lrr       $acc0.l, @$ar3
+	addax     $acc0,   $acx1
+	srr       @$ar3,   $acc0.l
+// ^ Adjust Relative Frequency Offsets ^
+	
+// v Read Samples Loop v
+	lr        $ar0,    @WORK_NEXT_SAMPLE_FUNCTION
+	lri       $ar3,    #resample_half_step_read_loop_end
+	bloop     $acc0.m, next_sample_complete
+	jmpr      $ar0
+resample_half_step_read_loop_end:
+// ^ Read Samples Loop ^
+	
+// v Select Coefficients v
+	// this sample takes the buffer the last one did not
+	lri       $acc1.m, #(WORK_RESAMPLING_COEF_BUF + WORK_RESAMPLING_COEF_BUF_2)
+	lr        $acx1.h, @WORK_HALF_STEP_COEFS
+	mrr       $ar3,    $acx1.h
+	subr      $acc1.m, $acx1.h
+	sr        @WORK_HALF_STEP_COEFS, $acc1.m
+// ^ Select Coefficients ^
+	s40
+	clr       $acc0
+	jmp       resample_samples
+
+// whole step ratios such as 2:1 never move the fraction, so the same samples are read for every output sample
+// the coefficients of their one phase are calculated once per cycle by init_parameter_block
+// clobbers everything
+resample_whole_step:
+	mrr       $st1,    $ar3
+	
+// v Read Samples Loop v
+	clr       $acc1
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_HI
+	lr        $ar0,    @WORK_NEXT_SAMPLE_FUNCTION
+	lri       $ar3,    #resample_whole_step_read_loop_end
+	bloop     $acc0.m, next_sample_complete
+	jmpr      $ar0
+resample_whole_step_read_loop_end:
+// ^ Read Samples Loop ^
+	
+	s40
+	clr       $acc0
+	lri       $ar3,    #WORK_RESAMPLING_COEF_BUF
+	jmp       resample_samples
+
+// same as the coefficient calculation in resample, for the samples read and fraction in $acc0
+// leaves the coefficients followed by the error factor in WORK_RESAMPLING_COEF_BUF
+// clobbers $acc0, $acc1, $acx1, $ix0, $ar0, $ar3
+calculate_coefficients:
+	lri       $wr0,    #0x01FC // the coefficient ROM wraps like in the core loop
+	
+// v Setup Coefficients Addressing v
+	lri       $ar3,    #WORK_FILTER_STEP
+	
+	lsl       $acc0,   #15
+	not'l     $acc0.m                     : $acx1.h, @$ar3            // filter step
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+	lsr       $acc0,   #6
+	andi      $acc0.m, #0x01FC
+	ori       $acc0.m, #0x1403
+	mrr       $ar0,    $acc0.m
+// ^ Setup Coefficients Addressing ^
+	lrri      $ix0,    @$ar3                                          // filter step 512
+	
+	movr'ldaxn    $acc1,   $acx0.h        : $acx1,   @$ar0
+	
+	mul       $acx1.l, $acx1.h
+	bloop     $acx0.l, calculate_coefficients_loop_end
+	subp'lsn  $acc1                       : $acx1.h, $acc0.m
+calculate_coefficients_loop_end:
+	mulmv         $acx1.l, $acx1.h, $acc0
+	
+	s40's                                 : @$ar3,   $acc0.m
+	addr'ir   $acc1.m, $acx0.h            : $ar3
+	clr's     $acc0                       : @$ar3,   $acc1.m          // error factor
+	
+	lri       $wr0,    #0xFFFF
+	ret
+
 // --- Parameter block Functions --- //
 
 // loads $ar0 with the address of the current pb with offset in $ix0
@@ -505,6 +1261,161 @@ init_pb_copy_end:
 	srri          @$ar3,   $acx0.l
 // ^ load parameter block vals ^
 	
+// v Pitch Glide setup v
+	clr       $acc1
+	lri       $ix0,    #PB_GLIDE_CYCLES
+	call      set_pb_address
+	lrr       $acc1.m, @$ar0
+	tst       $acc1
+	jeq       init_pb_glide_end
+	decm      $acc1.m
+	srri      @$ar0,   $acc1.m
+	jeq       init_pb_glide_finished
+	
+	lrri      $acc1.m, @$ar0
+	cmpi      $acc1.m, #GLIDE_MODE_EXPONENTIAL
+	jeq       init_pb_glide_exponential
+	
+	// add a constant delta every cycle
+	lrri      $acx1.h, @$ar0
+	lrr       $acx1.l, @$ar0
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_HI
+	lr        $acc0.l, @WORK_REL_FREQ_LO
+	addax     $acc0,   $acx1
+	jmp       init_pb_glide_store
+init_pb_glide_exponential:
+	// multiply by a constant (1 + factor) every cycle
+	// factor is split into a signed high half and the low half shifted right by 1 so both multiply as signed
+	// freq * factor = 2 * hi(freq) * hi(factor) + (2 * hi(freq) * lo(factor) + 2 * (lo(freq) >> 1) * hi(factor)) >> 15
+	lrri      $acx1.h, @$ar0                                          // factor high
+	lrr       $acx1.l, @$ar0                                          // factor low >> 1
+	clr       $acc1
+	lr        $acc1.m, @WORK_REL_FREQ_HI
+	mulc      $acc1.m, $acx1.h
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_LO
+	lsr       $acc0,   #1
+	movp      $acc1
+	mulc      $acc0.m, $acx1.h
+	lr        $acx1.h, @WORK_REL_FREQ_HI
+	movp      $acc0
+	mul       $acx1.l, $acx1.h
+	addp      $acc0
+	asr       $acc0,   #15
+	add       $acc0,   $acc1
+	lr        $acx1.h, @WORK_REL_FREQ_HI
+	lr        $acx1.l, @WORK_REL_FREQ_LO
+	addax     $acc0,   $acx1
+	jmp       init_pb_glide_store
+init_pb_glide_finished:
+	// land exactly on the target frequency
+	lri       $ix0,    #PB_GLIDE_TARGET_HI
+	call      set_pb_address
+	clr       $acc0
+	lrri      $acc0.m, @$ar0
+	lrr       $acc0.l, @$ar0
+init_pb_glide_store:
+	sr        @WORK_REL_FREQ_HI, $acc0.m
+	sr        @WORK_REL_FREQ_LO, $acc0.l
+	lri       $ix0,    #PB_REL_FREQ_HI
+	call      set_pb_address
+	srri      @$ar0,   $acc0.m
+	srr       @$ar0,   $acc0.l
+	
+	lr        $acc0.m, @WORK_FLAGS
+init_pb_glide_end:
+// ^ Pitch Glide setup ^
+	
+// v LFO setup v
+	clr       $acc1
+	lri       $acc1.m, #0x7FFF
+	sr        @WORK_LFO_GAIN, $acc1.m
+	
+	clr       $acc1
+	lri       $ix0,    #PB_LFO_SHAPE
+	call      set_pb_address
+	lrri      $acc1.m, @$ar0
+	tst       $acc1
+	jeq       init_pb_lfo_end
+	
+	// advance the phase once per cycle
+	clr       $acc0
+	lrri      $acc0.m, @$ar0
+	lrrd      $acx1.l, @$ar0                                          // phase step
+	addr      $acc0.m, $acx1.l
+	srr       @$ar0,   $acc0.m
+	
+	// evaluate the shape at the new phase as a signed value in $acc0.m
+	mrr       $acx1.h, $acc0.m
+	movr      $acc0,   $acx1.h
+	cmpi      $acc1.m, #LFO_SHAPE_TRIANGLE
+	jeq       init_pb_lfo_triangle
+	cmpi      $acc1.m, #LFO_SHAPE_SQUARE
+	jeq       init_pb_lfo_square
+init_pb_lfo_sine:
+	// parabolic approximation of sin(pi * x) = 4 * x * (1 - |x|)
+	abs       $acc0
+	neg       $acc0
+	addi      $acc0.m, #0x7FFF
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+	lsl       $acc0,   #2
+	jmp       init_pb_lfo_shape_end
+init_pb_lfo_triangle:
+	abs       $acc0
+	lsl       $acc0,   #1
+	lri       $acx1.h, #0x7FFF
+	subr      $acc0.m, $acx1.h
+	cmpi      $acc0.m, #0x7FFF
+	jle       init_pb_lfo_shape_end
+	clr       $acc0
+	lri       $acc0.m, #0x7FFF
+	jmp       init_pb_lfo_shape_end
+init_pb_lfo_square:
+	tst       $acc0
+	lri       $acc0.m, #0x7FFF
+	jge       init_pb_lfo_shape_end
+	lri       $acc0.m, #0x8001
+init_pb_lfo_shape_end:
+	sr        @WORK_LFO_VALUE, $acc0.m
+	
+	// tremolo, gain = 1 - depth * (1 - value) / 2
+	lr        $acx1.h, @WORK_LFO_VALUE
+	clr       $acc0
+	lri       $acc0.m, #0x7FFF
+	subr      $acc0.m, $acx1.h
+	lsr       $acc0,   #1
+	lri       $ix0,    #PB_LFO_VOLUME_DEPTH
+	call      set_pb_address
+	lrr       $acx1.h, @$ar0
+	mulc      $acc0.m, $acx1.h
+	clr       $acc0
+	lri       $acc0.m, #0x7FFF
+	subp      $acc0
+	sr        @WORK_LFO_GAIN, $acc0.m
+	
+	// vibrato, offset the relative frequency by depth * value
+	// filter step and buffer size stay at their unmodulated values so the sample history is kept
+	lr        $acx1.h, @WORK_LFO_VALUE
+	lri       $ix0,    #PB_LFO_PITCH_DEPTH
+	call      set_pb_address
+	clr       $acc0
+	lrr       $acc0.m, @$ar0
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+	asr       $acc0,   #13 // depth is in 1/8192ths of the base frequency
+	lr        $acx1.h, @WORK_REL_FREQ_HI
+	lr        $acx1.l, @WORK_REL_FREQ_LO
+	addax     $acc0,   $acx1
+	sr        @WORK_REL_FREQ_HI, $acc0.m
+	sr        @WORK_REL_FREQ_LO, $acc0.l
+	
+	lr        $acx1.l, @WORK_CURR_PB_ADDR
+	lr        $acc0.m, @WORK_FLAGS
+init_pb_lfo_end:
+// ^ LFO setup ^
+	
 // v Circular Buffer setup v
 	lri       $ar3,    #WORK_SAMPLE_BUFFER_INDEX
 	clr'l     $acc1                                  : $acx1.h, @$ar3
@@ -526,16 +1437,123 @@ init_pb_copy_end:
 // v Resampling Function Pointer setup v
 	lri       $ar0,    #WORK_REL_FREQ_LO
 	
+	clr       $acc1
 	lrrd      $acx1.h, @$ar0
 	tstaxh'l  $acx1.h                                : $acc1.m, @$ar0
 	jne       init_pb_resample
-	andcf     $acc1.m, #0x0001
-	jlnz      init_pb_resample
+	cmpi      $acc1.m, #0x0001
+	jne       init_pb_resample
 	
 	lri       $acc1.l, #resample_no_resample
 	jmp       init_pb_resample_end
 init_pb_resample:
+	lri       $ix0,    #PB_RESAMPLE_QUALITY
+	call      set_pb_address
+	clr       $acc1
+	lrr       $acc1.m, @$ar0
+	cmpi      $acc1.m, #RESAMPLE_QUALITY_NEAREST
+	jeq       init_pb_resample_nearest
+	cmpi      $acc1.m, #RESAMPLE_QUALITY_LINEAR
+	jeq       init_pb_resample_linear
+	
+	// a whole or half step keeps the phases fixed, so the coefficients are only calculated here
+	lr        $acc1.m, @WORK_REL_FREQ_LO
+	andf      $acc1.m, #0x7FFF
+	jlz       init_pb_resample_fixed
+	
+	// voices with a coefficient table skip calculating the coefficients for every sample
+	lri       $ix0,    #PB_RESAMPLE_TABLE_MASK
+	call      set_pb_address
+	lrri      $acx1.h, @$ar0
+	tstaxh    $acx1.h
+	jeq       init_pb_resample_rom
+	sr        @WORK_RESAMPLE_TABLE_MASK, $acx1.h
+	
+	call      wait_dma // the next pb may still be coming in
+	si        @DMACR,  #(DMA_DMEM | DMA_TO_DSP)
+	lrri      $acc0.m, @$ar0
+	lrr       $acc0.l, @$ar0
+	lri       $acc1.m, #RESAMPLE_TABLE_BASE
+	lr        $acc1.l, @CB_RESAMPLE_TABLE_SIZE
+	call      dma
+	
+	lr        $acc0.m, @WORK_FLAGS
+	lri       $acc1.l, #resample_table
+	jmp       init_pb_resample_end
+init_pb_resample_rom:
 	lri       $acc1.l, #resample
+	jmp       init_pb_resample_end
+init_pb_resample_nearest:
+	lri       $acc1.l, #resample_nearest
+	jmp       init_pb_resample_end
+init_pb_resample_linear:
+	lri       $acc1.l, #resample_linear
+	jmp       init_pb_resample_end
+init_pb_resample_fixed:
+	lr        $acc1.m, @WORK_REL_FREQ_LO
+	andf      $acc1.m, #0x8000
+	jlz       init_pb_resample_whole_step
+	
+	// the phase that follows a carry out of the fraction, with its top bit clear
+	s40
+	clr       $acc1
+	lr        $acc1.m, @WORK_COUNT_LO
+	andi      $acc1.m, #0x7FFF
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_HI
+	lr        $acc0.l, @WORK_REL_FREQ_LO
+	lri       $acx1.h, #0x0000
+	lri       $acx1.l, #0x8000
+	addax     $acc0,   $acx1
+	mrr       $acc0.l, $acc1.m
+	s16
+	call      calculate_coefficients
+	
+	lri       $ar0,    #WORK_RESAMPLING_COEF_BUF
+	lri       $ar3,    #WORK_RESAMPLING_COEF_BUF_2
+	
+	// copy 17 words $ar0 -> $ar3
+	bloopi    #17,     init_pb_resample_fixed_copy_end
+	lrri          $acx1.l, @$ar0
+init_pb_resample_fixed_copy_end:
+	srri          @$ar3,   $acx1.l
+	
+	// the phase without a carry, with the top bit set
+	s40
+	clr       $acc1
+	lr        $acc1.m, @WORK_COUNT_LO
+	ori       $acc1.m, #0x8000
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_HI
+	mrr       $acc0.l, $acc1.m
+	s16
+	call      calculate_coefficients
+	s16
+	
+	// the first sample flips the top bit of the fraction
+	lri       $acx1.h, #WORK_RESAMPLING_COEF_BUF
+	lr        $acc1.m, @WORK_COUNT_LO
+	andf      $acc1.m, #0x8000
+	jlz       init_pb_resample_half_step_first
+	lri       $acx1.h, #WORK_RESAMPLING_COEF_BUF_2
+init_pb_resample_half_step_first:
+	sr        @WORK_HALF_STEP_COEFS, $acx1.h
+	
+	lr        $acc0.m, @WORK_FLAGS
+	lri       $acc1.l, #resample_half_step
+	jmp       init_pb_resample_end
+init_pb_resample_whole_step:
+	// the fraction stays where it is, which makes its phase the only one
+	s40
+	clr       $acc0
+	lr        $acc0.m, @WORK_REL_FREQ_HI
+	lr        $acc0.l, @WORK_COUNT_LO
+	s16
+	call      calculate_coefficients
+	s16
+	
+	lr        $acc0.m, @WORK_FLAGS
+	lri       $acc1.l, #resample_whole_step
 init_pb_resample_end:
 	lri       $ar0,    #WORK_RESAMPLE_FUNCTION
 	srri      @$ar0,   $acc1.l
@@ -556,6 +1574,272 @@ channels_end:
 	clr's     $acc1                                  : @$ar0,   $acc1.l
 // ^ Mono or Stereo Function Pointers setup ^
 	
+// v Wide Mix setup v
+	lr        $acc0.m, @CB_MIX_FLAGS
+	andf      $acc0.m, #MIX_FLAG_WIDE
+	jlz       init_pb_wide_end
+	
+	lr        $acc0.m, @WORK_FLAGS
+	andf      $acc0.m, #VOICE_FLAG_STEREO
+	jlnz      init_pb_wide_stereo
+	lri       $acc1.l, #mix_mono_wide
+	jmp       init_pb_wide_store
+init_pb_wide_stereo:
+	lri       $acc1.l, #mix_stereo_wide
+init_pb_wide_store:
+	sr        @WORK_MIX_FUNCTION, $acc1.l
+init_pb_wide_end:
+	clr       $acc0
+	clr       $acc1
+// ^ Wide Mix setup ^
+	
+// v Aux Send setup v
+	lri       $ix0,    #PB_AUX_A_SEND
+	call      set_pb_address
+	lrri      $acc1.m, @$ar0
+	lrri      $acx1.h, @$ar0
+	sr        @WORK_AUX_A_SEND, $acc1.m
+	sr        @WORK_AUX_B_SEND, $acx1.h
+	orr       $acc1.m, $acx1.h
+	tst       $acc1
+	jeq       init_pb_aux_end
+	
+	lri       $ix2,    #((SOUND_BUFFER_SIZE / 2) - 2)
+	
+	lr        $acc0.m, @WORK_FLAGS
+	andf      $acc0.m, #VOICE_FLAG_STEREO
+	jlnz      init_pb_aux_stereo
+	lri       $acc1.l, #aux_mono
+	jmp       init_pb_aux_store
+init_pb_aux_stereo:
+	lri       $acc1.l, #aux_stereo
+init_pb_aux_store:
+	lr        $acc0.m, @WORK_MIX_FUNCTION
+	sr        @WORK_AUX_NEXT_FUNCTION, $acc0.m
+	sr        @WORK_MIX_FUNCTION, $acc1.l
+init_pb_aux_end:
+	clr       $acc0
+	clr       $acc1
+// ^ Aux Send setup ^
+	
+// v Meter setup v
+	lri       $ix0,    #PB_METER
+	call      set_pb_address
+	lrri      $acc1.m, @$ar0
+	tst       $acc1
+	jeq       init_pb_meter_end
+	
+	// the peak and power are accumulated in the parameter block, starting over each cycle
+	sr        @WORK_METER_ADDR, $ar0
+	clr       $acc1
+	srri      @$ar0,   $acc1.m
+	srri      @$ar0,   $acc1.m
+	srri      @$ar0,   $acc1.m
+	
+	lr        $acc0.m, @WORK_FLAGS
+	andf      $acc0.m, #VOICE_FLAG_STEREO
+	jlnz      init_pb_meter_stereo
+	lri       $acc1.l, #meter_mono
+	jmp       init_pb_meter_store
+init_pb_meter_stereo:
+	lri       $acc1.l, #meter_stereo
+init_pb_meter_store:
+	lr        $acc0.m, @WORK_MIX_FUNCTION
+	sr        @WORK_METER_NEXT_FUNCTION, $acc0.m
+	sr        @WORK_MIX_FUNCTION, $acc1.l
+init_pb_meter_end:
+	clr       $acc0
+	clr       $acc1
+// ^ Meter setup ^
+	
+// v Biquad Filter setup v
+	lri       $ix0,    #PB_BIQUAD_TYPE
+	call      set_pb_address
+	lrri      $acc1.m, @$ar0
+	tst       $acc1
+	jeq       init_pb_biquad_end
+	
+	// the coefficients are shared by both channels, the state of each is kept in the parameter block
+	lri       $ar3,    #WORK_BIQUAD_B0_HI
+	
+	// copy 10 words $ar0 -> $ar3
+	bloopi    #10,     init_pb_biquad_copy_end
+	lrri          $acx1.h, @$ar0
+init_pb_biquad_copy_end:
+	srri          @$ar3,   $acx1.h
+	
+	// the right state directly follows the coefficients
+	sr        @WORK_BIQUAD_R_ADDR, $ar0
+	lri       $ix0,    #PB_BIQUAD_L
+	call      set_pb_address_acx1
+	sr        @WORK_BIQUAD_L_ADDR, $ar0
+	
+	lr        $acc0.m, @WORK_FLAGS
+	andf      $acc0.m, #VOICE_FLAG_STEREO
+	jlnz      init_pb_biquad_stereo
+	lri       $acc1.l, #biquad_mono
+	jmp       init_pb_biquad_store
+init_pb_biquad_stereo:
+	lri       $acc1.l, #biquad_stereo
+init_pb_biquad_store:
+	lr        $acc0.m, @WORK_MIX_FUNCTION
+	sr        @WORK_BIQUAD_NEXT_FUNCTION, $acc0.m
+	sr        @WORK_MIX_FUNCTION, $acc1.l
+init_pb_biquad_end:
+	clr       $acc0
+	clr       $acc1
+// ^ Biquad Filter setup ^
+	
+// v Envelope & Gain setup v
+	lri       $ix0,    #PB_ENV_STATE
+	call      set_pb_address
+	lrri      $acc1.m, @$ar0
+	tst       $acc1
+	jne       init_pb_envelope
+	
+	// no envelope, only the lfo and mix group contribute to the gain
+	lr        $acc0.m, @WORK_LFO_GAIN
+	jmp       init_pb_group
+init_pb_envelope:
+	lrri      $acx1.h, @$ar0
+	lrr       $acx1.l, @$ar0
+	movax     $acc0,   $acx1
+	
+	// step the envelope level once per cycle
+	cmpi      $acc1.m, #ENVELOPE_STATE_ATTACK
+	jeq       init_pb_envelope_attack
+	cmpi      $acc1.m, #ENVELOPE_STATE_DECAY
+	jeq       init_pb_envelope_decay
+	cmpi      $acc1.m, #ENVELOPE_STATE_RELEASE
+	jeq       init_pb_envelope_release
+	jmp       init_pb_envelope_step_end
+init_pb_envelope_attack:
+	lri       $ix0,    #PB_ENV_ATTACK_HI
+	call      set_pb_address
+	lrri      $acx1.h, @$ar0
+	lrr       $acx1.l, @$ar0
+	addax     $acc0,   $acx1
+	cmpi      $acc0.m, #0x7FFF
+	jlt       init_pb_envelope_step_end
+	clr       $acc0
+	lri       $acc0.m, #0x7FFF
+	lri       $acc1.m, #ENVELOPE_STATE_DECAY
+	jmp       init_pb_envelope_step_end
+init_pb_envelope_decay:
+	lri       $ix0,    #PB_ENV_DECAY_HI
+	call      set_pb_address
+	lrri      $acx1.h, @$ar0
+	lrri      $acx1.l, @$ar0
+	subax     $acc0,   $acx1
+	lrr       $acx1.h, @$ar0                                          // sustain level
+	lri       $acx1.l, #0
+	subax     $acc0,   $acx1
+	jgt       init_pb_envelope_decay_continue
+	movax     $acc0,   $acx1
+	lri       $acc1.m, #ENVELOPE_STATE_SUSTAIN
+	jmp       init_pb_envelope_step_end
+init_pb_envelope_decay_continue:
+	addax     $acc0,   $acx1
+	jmp       init_pb_envelope_step_end
+init_pb_envelope_release:
+	lri       $ix0,    #PB_ENV_RELEASE_HI
+	call      set_pb_address
+	lrri      $acx1.h, @$ar0
+	lrr       $acx1.l, @$ar0
+	subax     $acc0,   $acx1
+	jgt       init_pb_envelope_step_end
+	clr       $acc0
+	// the release has reached silence, finish the voice at the end of this cycle
+	lr        $acc1.m, @WORK_FLAGS
+	ori       $acc1.m, #VOICE_FLAG_FINISHED
+	sr        @WORK_FLAGS, $acc1.m
+	lri       $acc1.m, #ENVELOPE_STATE_OFF
+init_pb_envelope_step_end:
+	lri       $ix0,    #PB_ENV_STATE
+	call      set_pb_address
+	srri      @$ar0,   $acc1.m
+	srri      @$ar0,   $acc0.m
+	srr       @$ar0,   $acc0.l
+	
+	lr        $acx1.h, @WORK_LFO_GAIN
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+init_pb_group:
+	clr       $acc1
+	lr        $acc1.m, @WORK_GROUP_VOLUME
+	cmpi      $acc1.m, #0x7FFF
+	jeq       init_pb_group_end
+	mrr       $acx1.h, $acc1.m
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+init_pb_group_end:
+	// keep ramping until the previous gain is back at unity too
+	cmpi      $acc0.m, #0x7FFF
+	jne       init_pb_gain
+	lri       $ix0,    #PB_GAIN
+	call      set_pb_address
+	lrr       $acc1.m, @$ar0
+	cmpi      $acc1.m, #0x7FFF
+	jne       init_pb_gain
+	jmp       init_pb_no_gain
+init_pb_gain:
+	// ramp from the previous gain to the new one across this cycle, delta = (end - start) * 272 / 65536
+	// slightly undershoots 1/240 so the gain never passes the value stored for the next cycle
+	lri       $ix0,    #PB_GAIN
+	call      set_pb_address
+	lrr       $acx1.h, @$ar0
+	srr       @$ar0,   $acc0.m
+	lri       $acx1.l, #0
+	sr        @WORK_GAIN_HI, $acx1.h
+	sr        @WORK_GAIN_LO, $acx1.l
+	
+	clr       $acc1
+	mrr       $acc1.m, $acc0.m
+	subr      $acc1.m, $acx1.h
+	lri       $acx1.h, #136
+	mulc      $acc1.m, $acx1.h
+	movp      $acc1
+	sr        @WORK_GAIN_DELTA_HI, $acc1.m
+	sr        @WORK_GAIN_DELTA_LO, $acc1.l
+	
+	lri       $acx1.l, #apply_gain
+	lri       $ar0,    #WORK_R_GAIN_VOL
+	jmp       init_pb_gain_end
+init_pb_no_gain:
+	lri       $ix0,    #PB_GAIN
+	call      set_pb_address
+	srr       @$ar0,   $acc0.m
+	lr        $acx1.l, @WORK_RESAMPLE_FUNCTION
+	lri       $ar0,    #WORK_R_VOL
+init_pb_gain_end:
+	sr        @WORK_RAMP_NEXT_FUNCTION, $acx1.l
+	sr        @WORK_MIX_VOLUME, $ar0
+	clr       $acc0
+	clr       $acc1
+// ^ Envelope & Gain setup ^
+	
+// v Volume Ramp setup v
+	lri       $ix0,    #PB_VOL_RAMP_CYCLES
+	call      set_pb_address
+	lrri      $acx1.h, @$ar0
+	tstaxh    $acx1.h
+	jeq       init_pb_no_volume_ramp
+	
+	// copy 6 words $ar0 -> $ar3
+	lri       $ar3,    #WORK_R_VOL_LO
+	bloopi    #6,      init_pb_volume_ramp_copy_end
+	lrri          $acx1.l, @$ar0
+init_pb_volume_ramp_copy_end:
+	srri          @$ar3,   $acx1.l
+	
+	lri       $acx1.l, #ramp_volume
+	jmp       init_pb_volume_ramp_end
+init_pb_no_volume_ramp:
+	lr        $acx1.l, @WORK_RAMP_NEXT_FUNCTION
+init_pb_volume_ramp_end:
+	sr        @WORK_SAMPLE_FUNCTION, $acx1.l
+// ^ Volume Ramp setup ^
+	
 // v Output Sound Buffer Address & Delay setup v
 	lri       $ar0,    #WORK_DELAY
 	lrr       $acc0.m, @$ar0
@@ -569,15 +1853,35 @@ init_pb_delay_no_samples:
 	jmp       init_pb_delay_end
 init_pb_delay_some_samples:
 	lsl       $acc0,   #1
+	srr       @$ar0,   $acc0.l
+	mrr       $ar0,    $acc0.m
+	addi      $acc0.m, #AUX_BUFFER_BASE
+	sr        @WORK_AUX_ADDR, $acc0.m
+	
+	// the wide mix buffer takes two words per sample
+	lr        $acc0.m, @CB_MIX_FLAGS
+	andf      $acc0.m, #MIX_FLAG_WIDE
+	jlnz      init_pb_delay_wide
+	mrr       $acc0.m, $ar0
 	addi      $acc0.m, #SOUND_BUFFER_BASE
+	jmp       init_pb_delay_store
+init_pb_delay_wide:
+	mrr       $acc0.m, $ar0
+	lsl       $acc0,   #1
+	addi      $acc0.m, #MIX_BUFFER_BASE
+init_pb_delay_store:
 	mrr       $ar3,    $acc0.m
-	srr       @$ar0,   $acc0.l
 init_pb_delay_end:
+	
+	// lets the meter average over the samples actually mixed
+	lri       $ix0,    #PB_METER_SAMPLES
+	call      set_pb_address
+	srr       @$ar0,   $acc1.m
 // ^ Output Sound Buffer Address & Delay setup ^
 	
 	ret
 
-// clobbers $acc0.m, $acx1.l, $ix0, $ar0, $ar3
+// clobbers $acc0, $acc1, $acx1.l, $ix0, $ar0, $ar3
 uninit_parameter_block:
 	call      uninit_accelerator
 	
@@ -596,6 +1900,46 @@ uninit_parameter_block:
 	andi      $acc0.m, #0x000F
 	clr's     $acc0                                  : @$ar0,   $acc0.m
 	
+// v Volume Ramp write back v
+	lri       $ix0,    #PB_VOL_RAMP_CYCLES
+	call      set_pb_address_acx1
+	lrr       $acc0.m, @$ar0
+	tst       $acc0
+	jeq       uninit_pb_volume_ramp_end
+	decm      $acc0.m
+	srri      @$ar0,   $acc0.m
+	jeq       uninit_pb_volume_ramp_finished
+	
+	// copy 6 words $ar3 -> $ar0
+	lri       $ar3,    #WORK_R_VOL_LO
+	bloopi    #6,      uninit_pb_volume_ramp_copy_end
+	lrri          $acc1.m, @$ar3
+uninit_pb_volume_ramp_copy_end:
+	srri          @$ar0,   $acc1.m
+	
+	lri       $ix0,    #PB_R_VOL
+	call      set_pb_address_acx1
+	lr        $acc1.m, @WORK_R_VOL
+	srri      @$ar0,   $acc1.m
+	lr        $acc1.m, @WORK_L_VOL
+	srr       @$ar0,   $acc1.m
+	jmp       uninit_pb_volume_ramp_end
+uninit_pb_volume_ramp_finished:
+	// the ramp is over, land exactly on the target volumes
+	clr       $acc1
+	loopi     #6
+	srri      @$ar0,   $acc1.m
+	lrri      $acc1.m, @$ar0
+	lrr       $acc0.m, @$ar0
+	lri       $ix0,    #PB_R_VOL
+	call      set_pb_address_acx1
+	srri      @$ar0,   $acc1.m
+	srr       @$ar0,   $acc0.m
+uninit_pb_volume_ramp_end:
+	clr       $acc0
+	clr       $acc1
+// ^ Volume Ramp write back ^
+	
 	ret
 
 // assumes current pb address is in $acx1.l
@@ -772,15 +2116,91 @@ clear_audio_buffer:
 	lri       $ar0,    #SOUND_BUFFER_BASE
 	loop      $acc0.l
 	srri      @$ar0,   $acc0.m
+	lri       $acc0.l, #((SOUND_BUFFER_SIZE / 2) * MAX_AUX_BUSES)
+	lri       $ar0,    #AUX_BUFFER_BASE
+	loop      $acc0.l
+	srri      @$ar0,   $acc0.m
+	lri       $acc0.l, #SOUND_BUFFER_SIZE
+	lri       $ar0,    #MIX_BUFFER_BASE
+	loop      $acc0.l
+	srri      @$ar0,   $acc0.m
 	ret
 
+// converts the wide mix buffer into the sound buffer, applying the master gain and saturating once
+// clobbers $acc0, $acc1, $acx1, $ar0, $ar3
+resolve_wide_mix:
+	lri       $ar0,    #MIX_BUFFER_BASE
+	lri       $ar3,    #SOUND_BUFFER_BASE
+	lr        $acx1.h, @CB_MASTER_GAIN
+	lr        $acc0.m, @CB_MIX_FLAGS
+	andf      $acc0.m, #MIX_FLAG_MASTER_GAIN
+	jlnz      resolve_wide_mix_gain
+	
+	bloopi    #NUMBER_SAMPLES, resolve_wide_mix_unity_loop_end
+	lrri          $acc0.m, @$ar0                                      // right high
+	lrri          $acc0.l, @$ar0                                      // right low
+	iar           $ar0
+	lrrd          $acc1.m, @$ar0                                      // left high
+	lrri          $acc1.l, @$ar0                                      // left low
+	iar           $ar0
+	asl           $acc0,   #8
+	asl           $acc1,   #8
+	srri          @$ar3,   $acc0.m
+resolve_wide_mix_unity_loop_end:
+	srri          @$ar3,   $acc1.m
+	ret
+	
+resolve_wide_mix_gain:
+	bloopi    #NUMBER_SAMPLES, resolve_wide_mix_gain_loop_end
+	lrri          $acc0.m, @$ar0                                      // right high
+	lrri          $acc0.l, @$ar0                                      // right low
+	call          apply_master_gain
+	srri          @$ar3,   $acc0.m
+	iar           $ar0
+	lrrd          $acc0.m, @$ar0                                      // left high
+	lrri          $acc0.l, @$ar0                                      // left low
+	iar           $ar0
+	call          apply_master_gain
+resolve_wide_mix_gain_loop_end:
+	srri          @$ar3,   $acc0.m
+	ret
+
+// scales the wide sample in $acc0.ml by the 1.15 gain in $acx1.h, leaving the result in $acc0.m
+// the high and low words are multiplied separately, the low word as unsigned 15 bits
+// clobbers $acc0, $acc1
+apply_master_gain:
+	clr       $acc1
+	mrr       $acc1.l, $acc0.l
+	lsl       $acc1,   #15
+	mulc      $acc0.m, $acx1.h
+	movp      $acc0
+	mulc      $acc1.m, $acx1.h
+	asl       $acc0,   #8
+	movp      $acc1
+	asr       $acc1,   #7
+	add       $acc0,   $acc1
+	ret
+
+// clobbers $acc0, $acc1, $acx1, $ar0, $ar3
 send_audio_buffer:
+	lr        $acc0.m, @CB_MIX_FLAGS
+	andf      $acc0.m, #MIX_FLAG_WIDE
+	jlz       send_audio_buffer_dma
+	call      resolve_wide_mix
+send_audio_buffer_dma:
 	si        @DMACR,  #(DMA_DMEM | DMA_TO_CPU)
 	lr        $acc0.m, @WORK_MMEM_SOUND_BUF_BASE_HI
 	lr        $acc0.l, @WORK_MMEM_SOUND_BUF_BASE_LO
 	lri       $acc1.m, #SOUND_BUFFER_BASE
 	lri       $acc1.l, #SOUND_BUFFER_SIZE
 	call      dma
+	
+	// the aux buses are back to back in both memories
+	lr        $acc0.m, @WORK_MMEM_AUX_BUF_BASE_HI
+	lr        $acc0.l, @WORK_MMEM_AUX_BUF_BASE_LO
+	lri       $acc1.m, #AUX_BUFFER_BASE
+	lri       $acc1.l, #(SOUND_BUFFER_SIZE * MAX_AUX_BUSES)
+	call      dma
 	ret
 
 // clobbers $acc0.m, $acc1.m, $ar0, $ar3
@@ -797,22 +2217,122 @@ swap_audio_buffers_loop_end:
 	
 	ret
 
+// fetches the first command block and keeps the main memory locations it carries, then starts the first cycle
 recv_mmem_base:
-	lri       $ar0,    #WORK_MMEM_PB_ARRAY_BASE_HI
-	
-	bloopi    #3,      recv_mmem_base_loop_end
-	call          wait_mail_recv
-	srri          @$ar0,   $acc0.m
+	call      wait_mail_recv
+	sr        @WORK_MMEM_COMMAND_BLOCK_HI, $acc0.m
+	sr        @WORK_MMEM_COMMAND_BLOCK_LO, $acc0.l
+	call      load_command_block
+	
+	lri       $ar0,    #CB_MMEM_PB_ARRAY_BASE_HI
+	lri       $ar3,    #WORK_MMEM_PB_ARRAY_BASE_HI
+	bloopi    #6,      recv_mmem_base_loop_end
+	lrri          $acx1.l, @$ar0
 recv_mmem_base_loop_end:
-	srri          @$ar0,   $acc0.l
+	srri          @$ar3,   $acx1.l
 	
-	jmp       wait_command
+	lri       $ar0,    #CB_MMEM_AUX_BUF_BASE_HI
+	lri       $ar3,    #WORK_MMEM_AUX_BUF_BASE_HI
+	bloopi    #2,      recv_mmem_base_extra_loop_end
+	lrri          $acx1.l, @$ar0
+recv_mmem_base_extra_loop_end:
+	srri          @$ar3,   $acx1.l
+	
+	jmp       restart_processing
+
+// loads $acc0.ml with the main memory address of the current pb
+// clobbers $acc0, $acx1
+set_pb_mmem_address:
+	clr       $acc0
+	lr        $acc0.l, @WORK_CURR_PB_INDEX
+set_pb_mmem_address_acc0: // use if $acc0 already has the pb index in $acc0.l
+	lsl       $acc0,   #8 // index * PARAMETER_BLOCK_STRUCT_SIZE
+	lr        $acx1.h, @WORK_MMEM_PB_ARRAY_BASE_HI
+	lr        $acx1.l, @WORK_MMEM_PB_ARRAY_BASE_LO
+	addax     $acc0,   $acx1
+	ret
+
+// starts copying the pb at voice list position $acc1.m from main memory into the pb buffer not in use,
+// does nothing past the end of the list
+// clobbers $acc0, $acc1, $acx1, $ar0
+prefetch_parameter_block:
+	clr       $acc0
+	lr        $acc0.m, @CB_VOICE_COUNT
+	cmp
+	retle
+	addi      $acc1.m, #CB_VOICE_LIST
+	mrr       $ar0,    $acc1.m
+	lrr       $acc1.m, @$ar0
+	sr        @WORK_NEXT_PB_INDEX, $acc1.m
+	
+	// PB_BUFFER_BASE is 0, so this flips between both buffers
+	lr        $acc0.m, @WORK_CURR_PB_ADDR
+	xori      $acc0.m, #PB_BUFFER_2_BASE
+	sr        @WORK_NEXT_PB_ADDR, $acc0.m
+	
+	call      wait_dma // the previous write-back may still be running
+	clr       $acc0
+	lr        $acc0.l, @WORK_NEXT_PB_INDEX
+	call      set_pb_mmem_address_acc0
+	si        @DMACR,  #(DMA_DMEM | DMA_TO_DSP)
+	lr        $acc1.m, @WORK_NEXT_PB_ADDR
+	lri       $acc1.l, #PARAMETER_BLOCK_STRUCT_SIZE
+	call      dma_no_wait
+	ret
 
-init_pb_dma:
-	lr        $acc0.m, @WORK_MMEM_PB_ARRAY_BASE_HI
-	lr        $acc0.l, @WORK_MMEM_PB_ARRAY_BASE_LO
-	lri       $acc1.m, #PB_ARRAY_BASE
-	lri       $acc1.l, #(PARAMETER_BLOCK_STRUCT_SIZE * MAX_PARAMETER_BLOCKS)
+// fetches the command block, then starts fetching the first parameter block of the cycle into the first buffer
+// a command block of another version is left without one
+// clobbers $acc0, $acc1, $ar0
+prefetch_cycle:
+	call      load_command_block
+	
+	lr        $acc0.m, @CB_VERSION
+	cmpi      $acc0.m, #COMMAND_BLOCK_VERSION
+	retne
+	
+	lri       $ar0,    #PB_BUFFER_2_BASE
+	sr        @WORK_CURR_PB_ADDR, $ar0
+	clr       $acc1
+	sr        @WORK_VOICE_LIST_INDEX, $acc1.m
+	call      prefetch_parameter_block
+	ret
+
+// the CPU flushes the mix table whenever a group changes, not only when it syncs
+// so a prefetched cycle fetches it again when it starts
+// clobbers $acc0, $acc1, $acx1
+load_mix_table:
+	si        @DMACR,  #(DMA_DMEM | DMA_TO_DSP)
+	clr       $acc0
+	lr        $acc0.m, @WORK_MMEM_COMMAND_BLOCK_HI
+	lr        $acc0.l, @WORK_MMEM_COMMAND_BLOCK_LO
+	lri       $acx1.h, #0x0000
+	lri       $acx1.l, #((CB_GROUP_TABLE - COMMAND_BLOCK_BASE) * 2)
+	addax     $acc0,   $acx1
+	lri       $acc1.m, #CB_GROUP_TABLE
+	lri       $acc1.l, #MIX_TABLE_SIZE
+	call      dma
+	ret
+
+// copies the command block with the voice list, mix group table and master settings from main memory
+// clobbers $acc0, $acc1
+load_command_block:
+	si        @DMACR,  #(DMA_DMEM | DMA_TO_DSP)
+	lr        $acc0.m, @WORK_MMEM_COMMAND_BLOCK_HI
+	lr        $acc0.l, @WORK_MMEM_COMMAND_BLOCK_LO
+	lri       $acc1.m, #COMMAND_BLOCK_BASE
+	lri       $acc1.l, #COMMAND_BLOCK_SIZE
+	call      dma
+	ret
+
+// starts copying the current pb from the pb buffer back to main memory, which overlaps with the next voice
+// clobbers $acc0, $acc1, $acx1
+store_parameter_block:
+	call      wait_dma // the next pb may still be coming in
+	call      set_pb_mmem_address
+	si        @DMACR,  #(DMA_DMEM | DMA_TO_CPU)
+	lr        $acc1.m, @WORK_CURR_PB_ADDR
+	lri       $acc1.l, #PARAMETER_BLOCK_STRUCT_SIZE
+	call      dma_no_wait
 	ret
 
 // --- Communications --- //